@@ -1,5 +1,6 @@
 #include "config.h"
 #include <storage/storage.h>
+#include "../disk/cow_overlay.h"
 
 #define TAG "Boot2FlipperConfig"
 
@@ -15,6 +16,10 @@ Boot2FlipperConfig* config_alloc() {
     config->network_interface = furi_string_alloc_set("auto"); // Default: auto-detect
     config->partition_scheme = PARTITION_SCHEME_GPT_ONLY; // Default: GPT (UEFI)
     config->chainload_enabled = true; // Default: chainloading enabled
+    config->sectors_per_cluster = SECTORS_PER_CLUSTER_AUTO; // Default: automatic
+    config->min_disk_size_mb = 0; // Default: 128MB for GPT, 32MB for MBR
+    config->image_path = furi_string_alloc(); // Default: virtual FAT
+    config->write_overlay_sectors = 0; // Default: read-only disk
 
     return config;
 }
@@ -28,6 +33,7 @@ void config_free(Boot2FlipperConfig* config) {
     furi_string_free(config->dns);
     furi_string_free(config->chainload_url);
     furi_string_free(config->network_interface);
+    furi_string_free(config->image_path);
 
     free(config);
 }
@@ -44,6 +50,10 @@ void config_copy(Boot2FlipperConfig* dest, const Boot2FlipperConfig* src) {
     furi_string_set(dest->network_interface, src->network_interface);
     dest->partition_scheme = src->partition_scheme;
     dest->chainload_enabled = src->chainload_enabled;
+    dest->sectors_per_cluster = src->sectors_per_cluster;
+    dest->min_disk_size_mb = src->min_disk_size_mb;
+    furi_string_set(dest->image_path, src->image_path);
+    dest->write_overlay_sectors = src->write_overlay_sectors;
 }
 
 bool config_save(Storage* storage, const Boot2FlipperConfig* config, const char* file_path) {
@@ -124,6 +134,32 @@ bool config_save(Storage* storage, const Boot2FlipperConfig* config, const char*
             break;
         }
 
+        // Write cluster size
+        uint32_t sectors_per_cluster = config->sectors_per_cluster;
+        if(!flipper_format_write_uint32(file, "Cluster_Size", &sectors_per_cluster, 1)) {
+            FURI_LOG_E(TAG, "Failed to write cluster size");
+            break;
+        }
+
+        // Write minimum disk size
+        if(!flipper_format_write_uint32(file, "Min_Disk_Size", &config->min_disk_size_mb, 1)) {
+            FURI_LOG_E(TAG, "Failed to write minimum disk size");
+            break;
+        }
+
+        // Write raw image path
+        if(!flipper_format_write_string(file, "Image_Path", config->image_path)) {
+            FURI_LOG_E(TAG, "Failed to write image path");
+            break;
+        }
+
+        // Write write overlay size
+        uint32_t write_overlay_sectors = config->write_overlay_sectors;
+        if(!flipper_format_write_uint32(file, "Write_Overlay", &write_overlay_sectors, 1)) {
+            FURI_LOG_E(TAG, "Failed to write write overlay size");
+            break;
+        }
+
         success = true;
         FURI_LOG_I(TAG, "Configuration saved successfully to %s", file_path);
 
@@ -223,6 +259,53 @@ bool config_load(Storage* storage, Boot2FlipperConfig* config, const char* file_
             config->chainload_enabled = true;
         }
 
+        // Read cluster size (optional for backward compatibility)
+        uint32_t sectors_per_cluster = SECTORS_PER_CLUSTER_AUTO;
+        if(flipper_format_read_uint32(file, "Cluster_Size", &sectors_per_cluster, 1)) {
+            config->sectors_per_cluster = (uint8_t)sectors_per_cluster;
+        } else {
+            FURI_LOG_W(TAG, "Cluster size not found, using default (automatic)");
+            config->sectors_per_cluster = SECTORS_PER_CLUSTER_AUTO;
+        }
+
+        // Read minimum disk size (optional for backward compatibility)
+        if(!flipper_format_read_uint32(file, "Min_Disk_Size", &config->min_disk_size_mb, 1)) {
+            FURI_LOG_W(TAG, "Minimum disk size not found, using default (automatic)");
+            config->min_disk_size_mb = 0;
+        } else if(config->min_disk_size_mb > MAX_DISK_SIZE_MB) {
+            // Converted to a sector count, larger values would wrap
+            FURI_LOG_W(
+                TAG,
+                "Minimum disk size %luMB too large, using %luMB",
+                config->min_disk_size_mb,
+                (uint32_t)MAX_DISK_SIZE_MB);
+            config->min_disk_size_mb = MAX_DISK_SIZE_MB;
+        }
+
+        // Read raw image path (optional for backward compatibility)
+        if(!flipper_format_read_string(file, "Image_Path", config->image_path)) {
+            FURI_LOG_W(TAG, "Image path not found, using default (virtual FAT)");
+            furi_string_reset(config->image_path);
+        }
+
+        // Read write overlay size (optional for backward compatibility)
+        uint32_t write_overlay_sectors = 0;
+        if(flipper_format_read_uint32(file, "Write_Overlay", &write_overlay_sectors, 1)) {
+            // The overlay is allocated up front, a failed malloc would crash the device
+            if(write_overlay_sectors > COW_OVERLAY_MAX_BLOCKS) {
+                FURI_LOG_W(
+                    TAG,
+                    "Write overlay size %lu too large, using %u sectors",
+                    write_overlay_sectors,
+                    COW_OVERLAY_MAX_BLOCKS);
+                write_overlay_sectors = COW_OVERLAY_MAX_BLOCKS;
+            }
+            config->write_overlay_sectors = (uint16_t)write_overlay_sectors;
+        } else {
+            FURI_LOG_W(TAG, "Write overlay size not found, using default (read-only)");
+            config->write_overlay_sectors = 0;
+        }
+
         success = true;
         FURI_LOG_I(TAG, "Configuration loaded successfully from %s", file_path);
 
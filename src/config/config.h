@@ -22,6 +22,10 @@ typedef struct {
     FuriString* network_interface; // Network interface name (e.g., "net0", "net1")
     PartitionScheme partition_scheme; // MBR-only, GPT-only, or Hybrid
     bool chainload_enabled; // Enable/disable chainloading
+    uint8_t sectors_per_cluster; // FAT cluster size in sectors (0 = automatic)
+    uint32_t min_disk_size_mb; // Minimum virtual disk size in MB (0 = automatic)
+    FuriString* image_path; // Raw disk image to serve instead of the virtual FAT ("" = none)
+    uint16_t write_overlay_sectors; // Sectors of host writes kept in RAM (0 = read-only)
 } Boot2FlipperConfig;
 
 /**
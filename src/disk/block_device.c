@@ -0,0 +1,53 @@
+#include "block_device.h"
+
+struct BlockDevice {
+    const BlockDeviceApi* api;
+    void* context;
+};
+
+BlockDevice* block_device_alloc(const BlockDeviceApi* api, void* context) {
+    furi_check(api && api->get_geometry && api->read_blocks);
+
+    BlockDevice* device = malloc(sizeof(BlockDevice));
+    device->api = api;
+    device->context = context;
+    return device;
+}
+
+void block_device_free(BlockDevice* device) {
+    if(device == NULL) return;
+
+    if(device->api->free) {
+        device->api->free(device->context);
+    }
+
+    free(device);
+}
+
+bool block_device_get_geometry(BlockDevice* device, BlockDeviceGeometry* geometry) {
+    if(device == NULL || geometry == NULL) return false;
+    return device->api->get_geometry(device->context, geometry);
+}
+
+bool block_device_read_blocks(BlockDevice* device, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    if(device == NULL || buffer == NULL) return false;
+    return device->api->read_blocks(device->context, lba, count, buffer);
+}
+
+bool block_device_write_blocks(
+    BlockDevice* device,
+    uint32_t lba,
+    uint32_t count,
+    const uint8_t* buffer) {
+    if(device == NULL || buffer == NULL || device->api->write_blocks == NULL) return false;
+    return device->api->write_blocks(device->context, lba, count, buffer);
+}
+
+bool block_device_is_read_only(BlockDevice* device) {
+    return device == NULL || device->api->write_blocks == NULL;
+}
+
+void block_device_prefetch(BlockDevice* device, uint32_t lba, uint32_t count) {
+    if(device == NULL || device->api->prefetch == NULL) return;
+    device->api->prefetch(device->context, lba, count);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <furi.h>
+
+/**
+ * Block device - common interface between the SCSI layer and its backends
+ * Backends (virtual FAT, raw image) and decorators (caches, overlays) all
+ * expose a BlockDevice, so they can be stacked and swapped freely
+ */
+
+#define SECTOR_SIZE 512
+
+/**
+ * Block device geometry
+ */
+typedef struct {
+    uint32_t block_count; // Total number of blocks
+    uint32_t block_size; // Block size in bytes
+} BlockDeviceGeometry;
+
+/**
+ * Block device operations
+ * get_geometry and read_blocks are required, the rest may be NULL
+ */
+typedef struct {
+    bool (*get_geometry)(void* context, BlockDeviceGeometry* geometry);
+    bool (*read_blocks)(void* context, uint32_t lba, uint32_t count, uint8_t* buffer);
+    // NULL for read-only devices
+    bool (*write_blocks)(void* context, uint32_t lba, uint32_t count, const uint8_t* buffer);
+    // Hint that the host is about to read these blocks, NULL if not supported
+    void (*prefetch)(void* context, uint32_t lba, uint32_t count);
+    // Frees the context when the device is freed, NULL if the context is not owned
+    void (*free)(void* context);
+} BlockDeviceApi;
+
+typedef struct BlockDevice BlockDevice;
+
+/**
+ * Allocate block device
+ * @param api Operations (must outlive the device)
+ * @param context Context passed to every operation
+ * @return BlockDevice instance
+ */
+BlockDevice* block_device_alloc(const BlockDeviceApi* api, void* context);
+
+/**
+ * Free block device
+ * Calls api->free on the context if set, the backend itself is not freed
+ * @param device Instance
+ */
+void block_device_free(BlockDevice* device);
+
+/**
+ * Get device geometry
+ * @param device Instance
+ * @param geometry Output geometry
+ * @return true on success
+ */
+bool block_device_get_geometry(BlockDevice* device, BlockDeviceGeometry* geometry);
+
+/**
+ * Read consecutive blocks
+ * @param device Instance
+ * @param lba First Logical Block Address
+ * @param count Number of blocks to read
+ * @param buffer Output buffer (must be count * block_size bytes)
+ * @return true on success
+ */
+bool block_device_read_blocks(BlockDevice* device, uint32_t lba, uint32_t count, uint8_t* buffer);
+
+/**
+ * Write consecutive blocks
+ * @param device Instance
+ * @param lba First Logical Block Address
+ * @param count Number of blocks to write
+ * @param buffer Input buffer (count * block_size bytes)
+ * @return true on success, false on error or if the device is read-only
+ */
+bool block_device_write_blocks(
+    BlockDevice* device,
+    uint32_t lba,
+    uint32_t count,
+    const uint8_t* buffer);
+
+/**
+ * Check whether the device accepts writes
+ * @param device Instance
+ * @return true if write_blocks is not supported
+ */
+bool block_device_is_read_only(BlockDevice* device);
+
+/**
+ * Hint that blocks are about to be read
+ * No-op for devices without prefetch support
+ * @param device Instance
+ * @param lba First Logical Block Address
+ * @param count Number of blocks
+ */
+void block_device_prefetch(BlockDevice* device, uint32_t lba, uint32_t count);
@@ -0,0 +1,137 @@
+#include "cow_overlay.h"
+#include <string.h>
+
+#define TAG "CowOverlay"
+
+typedef struct {
+    uint32_t lba;
+    uint8_t* data; // One block, allocated on first write
+} CowOverlayEntry;
+
+typedef struct {
+    BlockDevice* base;
+    uint32_t block_size;
+    CowOverlayEntry* entries; // Sorted by LBA for binary search
+    uint16_t count;
+    uint16_t capacity;
+} CowOverlay;
+
+// Index of the first entry with LBA >= lba (count if none)
+static uint16_t cow_overlay_lower_bound(CowOverlay* overlay, uint32_t lba) {
+    uint16_t low = 0;
+    uint16_t high = overlay->count;
+
+    while(low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if(overlay->entries[mid].lba < lba) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+static bool cow_overlay_get_geometry(void* context, BlockDeviceGeometry* geometry) {
+    CowOverlay* overlay = context;
+    return block_device_get_geometry(overlay->base, geometry);
+}
+
+static bool cow_overlay_read(void* context, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    CowOverlay* overlay = context;
+
+    if(!block_device_read_blocks(overlay->base, lba, count, buffer)) return false;
+
+    // Patch in written blocks, the loop does not run for untouched ranges
+    for(uint16_t i = cow_overlay_lower_bound(overlay, lba);
+        i < overlay->count && overlay->entries[i].lba - lba < count;
+        i++) {
+        memcpy(
+            buffer + (overlay->entries[i].lba - lba) * overlay->block_size,
+            overlay->entries[i].data,
+            overlay->block_size);
+    }
+
+    return true;
+}
+
+static bool
+    cow_overlay_write(void* context, uint32_t lba, uint32_t count, const uint8_t* buffer) {
+    CowOverlay* overlay = context;
+
+    // Count the blocks not in the overlay yet, a write that does not fit is rejected whole
+    uint32_t missing = 0;
+    uint16_t present = cow_overlay_lower_bound(overlay, lba);
+    for(uint32_t i = 0; i < count; i++) {
+        if(present < overlay->count && overlay->entries[present].lba == lba + i) {
+            present++;
+        } else {
+            missing++;
+        }
+    }
+    if(missing > (uint32_t)(overlay->capacity - overlay->count)) {
+        FURI_LOG_E(TAG, "Overlay full, write to LBA %lu+%lu rejected", lba, count);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < count; i++) {
+        uint32_t block = lba + i;
+        uint16_t index = cow_overlay_lower_bound(overlay, block);
+
+        if(index >= overlay->count || overlay->entries[index].lba != block) {
+            memmove(
+                &overlay->entries[index + 1],
+                &overlay->entries[index],
+                (overlay->count - index) * sizeof(CowOverlayEntry));
+            overlay->entries[index].lba = block;
+            overlay->entries[index].data = malloc(overlay->block_size);
+            overlay->count++;
+        }
+
+        memcpy(
+            overlay->entries[index].data, buffer + i * overlay->block_size, overlay->block_size);
+    }
+
+    return true;
+}
+
+static void cow_overlay_prefetch(void* context, uint32_t lba, uint32_t count) {
+    CowOverlay* overlay = context;
+    block_device_prefetch(overlay->base, lba, count);
+}
+
+static void cow_overlay_free(void* context) {
+    CowOverlay* overlay = context;
+
+    FURI_LOG_I(TAG, "Discarding %u of %u blocks", overlay->count, overlay->capacity);
+
+    for(uint16_t i = 0; i < overlay->count; i++) {
+        free(overlay->entries[i].data);
+    }
+    free(overlay->entries);
+    free(overlay);
+}
+
+static const BlockDeviceApi cow_overlay_api = {
+    .get_geometry = cow_overlay_get_geometry,
+    .read_blocks = cow_overlay_read,
+    .write_blocks = cow_overlay_write,
+    .prefetch = cow_overlay_prefetch,
+    .free = cow_overlay_free,
+};
+
+BlockDevice* cow_overlay_alloc(BlockDevice* base, uint16_t max_blocks) {
+    BlockDeviceGeometry geometry;
+    if(max_blocks == 0 || !block_device_get_geometry(base, &geometry)) return NULL;
+    if(max_blocks > COW_OVERLAY_MAX_BLOCKS) max_blocks = COW_OVERLAY_MAX_BLOCKS;
+
+    CowOverlay* overlay = malloc(sizeof(CowOverlay));
+    overlay->base = base;
+    overlay->block_size = geometry.block_size;
+    overlay->entries = malloc(max_blocks * sizeof(CowOverlayEntry));
+    overlay->count = 0;
+    overlay->capacity = max_blocks;
+
+    return block_device_alloc(&cow_overlay_api, overlay);
+}
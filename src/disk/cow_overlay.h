@@ -0,0 +1,23 @@
+#pragma once
+
+#include <furi.h>
+#include "block_device.h"
+
+/**
+ * Copy-on-write overlay - makes a read-only block device writable
+ * Written blocks are kept in RAM and served back on later reads, the
+ * backend is never modified. Everything is discarded when the overlay is
+ * freed, so each USB session starts from the pristine disk.
+ */
+
+// Upper bound of the overlay size (128KB of 512-byte blocks), entries are allocated up front
+#define COW_OVERLAY_MAX_BLOCKS 256
+
+/**
+ * Allocate overlay on top of a block device
+ * Free with block_device_free, the base device stays owned by the caller
+ * @param base Device to overlay (must outlive the overlay)
+ * @param max_blocks Maximum number of distinct blocks kept in RAM (at most COW_OVERLAY_MAX_BLOCKS)
+ * @return BlockDevice instance, or NULL if the base geometry is unavailable
+ */
+BlockDevice* cow_overlay_alloc(BlockDevice* base, uint16_t max_blocks);
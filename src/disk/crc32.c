@@ -40,10 +40,14 @@ static const uint32_t crc32_table[256] = {
     0xCDD70693, 0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
     0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D};
 
-uint32_t crc32_calculate(const uint8_t* data, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t length) {
+    crc ^= 0xFFFFFFFF;
     for(size_t i = 0; i < length; i++) {
         crc = crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
     }
     return crc ^ 0xFFFFFFFF;
 }
+
+uint32_t crc32_calculate(const uint8_t* data, size_t length) {
+    return crc32_update(0, data, length);
+}
@@ -5,3 +5,6 @@
 
 // Calculate CRC32 checksum for GPT
 uint32_t crc32_calculate(const uint8_t* data, size_t length);
+
+// Continue a CRC32 over more data (crc = result of a previous call, 0 to start)
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t length);
@@ -1,7 +1,6 @@
 #include "gpt.h"
 #include "crc32.h"
 #include "virtual_fat.h"
-#include <stdlib.h>
 #include <string.h>
 
 #define SECTOR_SIZE 512
@@ -61,24 +60,25 @@ static void build_partition_entry(
     }
 }
 
-bool generate_gpt_header(
-    uint8_t* buffer,
-    uint32_t total_sectors,
-    uint32_t partition_start_lba,
-    uint32_t partition_sectors) {
-    memset(buffer, 0, SECTOR_SIZE);
-
-    // Pre-calculate partition array CRC32
+uint32_t gpt_partition_array_crc(uint32_t partition_start_lba, uint32_t partition_sectors) {
     // GPT spec: 128 entries × 128 bytes = 16384 bytes (32 sectors)
-    // Use malloc to avoid stack overflow on embedded systems
-    uint8_t* part_array = malloc(128 * 128);
-    if(!part_array) {
-        return false;
+    // Only the first entry is used, the rest is zero, so CRC it entry by entry
+    // instead of materializing the whole array
+    uint8_t entry[128];
+    memset(entry, 0, sizeof(entry));
+    build_partition_entry(entry, partition_start_lba, partition_sectors);
+    uint32_t crc = crc32_update(0, entry, sizeof(entry));
+
+    memset(entry, 0, sizeof(entry));
+    for(int i = 1; i < 128; i++) {
+        crc = crc32_update(crc, entry, sizeof(entry));
     }
-    memset(part_array, 0, 128 * 128);
-    build_partition_entry(part_array, partition_start_lba, partition_sectors);
-    uint32_t part_array_crc = crc32_calculate(part_array, 128 * 128);
-    free(part_array);
+
+    return crc;
+}
+
+bool generate_gpt_header(uint8_t* buffer, uint32_t total_sectors, uint32_t partition_array_crc) {
+    memset(buffer, 0, SECTOR_SIZE);
 
     // GPT Header signature
     memcpy(&buffer[0], "EFI PART", 8);
@@ -121,10 +121,11 @@ bool generate_gpt_header(
     memset(&buffer[44], 0, 4);
 
     // Last usable LBA (use macro)
-    buffer[48] = GPT_LAST_USABLE & 0xFF;
-    buffer[49] = (GPT_LAST_USABLE >> 8) & 0xFF;
-    buffer[50] = (GPT_LAST_USABLE >> 16) & 0xFF;
-    buffer[51] = (GPT_LAST_USABLE >> 24) & 0xFF;
+    uint32_t last_usable = GPT_LAST_USABLE(total_sectors);
+    buffer[48] = last_usable & 0xFF;
+    buffer[49] = (last_usable >> 8) & 0xFF;
+    buffer[50] = (last_usable >> 16) & 0xFF;
+    buffer[51] = (last_usable >> 24) & 0xFF;
     memset(&buffer[52], 0, 4);
 
     // Disk GUID
@@ -143,10 +144,10 @@ bool generate_gpt_header(
     memset(&buffer[85], 0, 3);
 
     // Partition array CRC32
-    buffer[88] = part_array_crc & 0xFF;
-    buffer[89] = (part_array_crc >> 8) & 0xFF;
-    buffer[90] = (part_array_crc >> 16) & 0xFF;
-    buffer[91] = (part_array_crc >> 24) & 0xFF;
+    buffer[88] = partition_array_crc & 0xFF;
+    buffer[89] = (partition_array_crc >> 8) & 0xFF;
+    buffer[90] = (partition_array_crc >> 16) & 0xFF;
+    buffer[91] = (partition_array_crc >> 24) & 0xFF;
 
     // Calculate header CRC32 (with CRC field = 0)
     uint32_t header_crc = crc32_calculate(buffer, 92);
@@ -170,20 +171,9 @@ bool generate_gpt_partitions(
 bool generate_gpt_backup_header(
     uint8_t* buffer,
     uint32_t total_sectors,
-    uint32_t partition_start_lba,
-    uint32_t partition_sectors) {
+    uint32_t partition_array_crc) {
     memset(buffer, 0, SECTOR_SIZE);
 
-    // Pre-calculate partition array CRC32 (same as primary)
-    uint8_t* part_array = malloc(128 * 128);
-    if(!part_array) {
-        return false;
-    }
-    memset(part_array, 0, 128 * 128);
-    build_partition_entry(part_array, partition_start_lba, partition_sectors);
-    uint32_t part_array_crc = crc32_calculate(part_array, 128 * 128);
-    free(part_array);
-
     // GPT Header signature
     memcpy(&buffer[0], "EFI PART", 8);
 
@@ -225,20 +215,22 @@ bool generate_gpt_backup_header(
     memset(&buffer[44], 0, 4);
 
     // Last usable LBA (use macro, same as primary)
-    buffer[48] = GPT_LAST_USABLE & 0xFF;
-    buffer[49] = (GPT_LAST_USABLE >> 8) & 0xFF;
-    buffer[50] = (GPT_LAST_USABLE >> 16) & 0xFF;
-    buffer[51] = (GPT_LAST_USABLE >> 24) & 0xFF;
+    uint32_t last_usable = GPT_LAST_USABLE(total_sectors);
+    buffer[48] = last_usable & 0xFF;
+    buffer[49] = (last_usable >> 8) & 0xFF;
+    buffer[50] = (last_usable >> 16) & 0xFF;
+    buffer[51] = (last_usable >> 24) & 0xFF;
     memset(&buffer[52], 0, 4);
 
     // Disk GUID (same as primary)
     memcpy(&buffer[56], DISK_GUID, 16);
 
     // Partition entries starting LBA (use macro for backup array start)
-    buffer[72] = GPT_BACKUP_ARRAY_START & 0xFF;
-    buffer[73] = (GPT_BACKUP_ARRAY_START >> 8) & 0xFF;
-    buffer[74] = (GPT_BACKUP_ARRAY_START >> 16) & 0xFF;
-    buffer[75] = (GPT_BACKUP_ARRAY_START >> 24) & 0xFF;
+    uint32_t backup_array_start = GPT_BACKUP_ARRAY_START(total_sectors);
+    buffer[72] = backup_array_start & 0xFF;
+    buffer[73] = (backup_array_start >> 8) & 0xFF;
+    buffer[74] = (backup_array_start >> 16) & 0xFF;
+    buffer[75] = (backup_array_start >> 24) & 0xFF;
     memset(&buffer[76], 0, 4);
 
     // Number of partition entries (128)
@@ -250,10 +242,10 @@ bool generate_gpt_backup_header(
     memset(&buffer[85], 0, 3);
 
     // Partition array CRC32 (same as primary)
-    buffer[88] = part_array_crc & 0xFF;
-    buffer[89] = (part_array_crc >> 8) & 0xFF;
-    buffer[90] = (part_array_crc >> 16) & 0xFF;
-    buffer[91] = (part_array_crc >> 24) & 0xFF;
+    buffer[88] = partition_array_crc & 0xFF;
+    buffer[89] = (partition_array_crc >> 8) & 0xFF;
+    buffer[90] = (partition_array_crc >> 16) & 0xFF;
+    buffer[91] = (partition_array_crc >> 24) & 0xFF;
 
     // Calculate header CRC32 (with CRC field = 0)
     uint32_t header_crc = crc32_calculate(buffer, 92);
@@ -4,12 +4,11 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+// Calculate CRC32 of the full partition entry array (128 entries, only the first used)
+uint32_t gpt_partition_array_crc(uint32_t partition_start_lba, uint32_t partition_sectors);
+
 // Generate GPT header at LBA 1
-bool generate_gpt_header(
-    uint8_t* buffer,
-    uint32_t total_sectors,
-    uint32_t partition_start_lba,
-    uint32_t partition_sectors);
+bool generate_gpt_header(uint8_t* buffer, uint32_t total_sectors, uint32_t partition_array_crc);
 
 // Generate GPT partition entry array at LBA 2
 bool generate_gpt_partitions(
@@ -21,8 +20,7 @@ bool generate_gpt_partitions(
 bool generate_gpt_backup_header(
     uint8_t* buffer,
     uint32_t total_sectors,
-    uint32_t partition_start_lba,
-    uint32_t partition_sectors);
+    uint32_t partition_array_crc);
 
 // Generate backup GPT partition entries (before last LBA)
 bool generate_gpt_backup_partitions(
@@ -4,6 +4,11 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+// MBR partition types
+#define MBR_TYPE_FAT12     0x01
+#define MBR_TYPE_FAT16_LBA 0x0E
+#define MBR_TYPE_EFI       0xEF
+
 // Generate MBR at LBA 0
 // Returns true if successful
 bool generate_mbr(
@@ -0,0 +1,87 @@
+#include "packed_file.h"
+#include <string.h>
+
+static uint32_t read_le32(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) |
+           ((uint32_t)data[3] << 24);
+}
+
+bool packed_file_is_packed(const uint8_t* data) {
+    return memcmp(data, PACKED_FILE_MAGIC, 4) == 0;
+}
+
+bool packed_file_parse_header(const uint8_t* data, PackedFileHeader* header) {
+    if(!packed_file_is_packed(data)) return false;
+
+    header->block_size = read_le32(data + 4);
+    header->size = read_le32(data + 8);
+    header->block_count = read_le32(data + 12);
+
+    uint32_t block_size = header->block_size;
+    if(block_size < 512 || block_size > PACKED_FILE_MAX_BLOCK_SIZE ||
+       (block_size & (block_size - 1)) != 0) {
+        return false;
+    }
+
+    uint32_t block_count = header->size / block_size + (header->size % block_size != 0 ? 1 : 0);
+    return header->block_count == block_count && block_count <= PACKED_FILE_MAX_BLOCKS;
+}
+
+// LZ4 length field: 15 in the token means more bytes follow, 255 means keep going
+static bool read_length(const uint8_t** ip, const uint8_t* iend, uint32_t* length) {
+    if(*length != 15) return true;
+
+    uint8_t byte;
+    do {
+        if(*ip >= iend) return false;
+        byte = *(*ip)++;
+        *length += byte;
+    } while(byte == 255);
+
+    return true;
+}
+
+bool packed_file_decompress(
+    const uint8_t* src,
+    uint32_t src_size,
+    uint8_t* dst,
+    uint32_t dst_size) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_size;
+
+    while(ip < iend) {
+        uint8_t token = *ip++;
+
+        // Literals
+        uint32_t literals = token >> 4;
+        if(!read_length(&ip, iend, &literals)) return false;
+        if(literals > (uint32_t)(iend - ip) || literals > (uint32_t)(oend - op)) return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // The last sequence has no match
+        if(ip >= iend) break;
+
+        // Match
+        if(iend - ip < 2) return false;
+        uint32_t offset = ip[0] | ((uint32_t)ip[1] << 8);
+        ip += 2;
+        if(offset == 0 || offset > (uint32_t)(op - dst)) return false;
+
+        uint32_t length = token & 0x0F;
+        if(!read_length(&ip, iend, &length)) return false;
+        length += 4;
+        if(length > (uint32_t)(oend - op)) return false;
+
+        // Byte by byte, matches may overlap their own output
+        const uint8_t* match = op - offset;
+        while(length--) {
+            *op++ = *match++;
+        }
+    }
+
+    return op == oend;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <furi.h>
+
+/**
+ * Packed file - block-compressed SD payload (see tools/b2fz.py)
+ * The file is split into independent LZ4 blocks with an offset index, so a
+ * read only fetches and decodes the blocks it touches.
+ *
+ * Layout (little-endian):
+ *   0  "B2FZ" magic
+ *   4  uint32 block size (power of two, 512 .. PACKED_FILE_MAX_BLOCK_SIZE)
+ *   8  uint32 uncompressed size
+ *   12 uint32 block count
+ *   16 uint32 offsets[block count + 1], file offset of each block and of the end
+ * A block whose packed length equals its uncompressed length is stored as is.
+ */
+
+#define PACKED_FILE_MAGIC          "B2FZ"
+#define PACKED_FILE_HEADER_SIZE    16
+#define PACKED_FILE_MAX_BLOCK_SIZE (16 * 1024) // Bounds the decode buffers
+#define PACKED_FILE_MAX_BLOCKS     1024 // Bounds the offset index (4KB)
+
+typedef struct {
+    uint32_t block_size;
+    uint32_t size; // Uncompressed size
+    uint32_t block_count;
+} PackedFileHeader;
+
+/**
+ * Check for the packed file magic
+ * @param data First bytes of the file (at least PACKED_FILE_HEADER_SIZE)
+ * @return true if the file is a packed file
+ */
+bool packed_file_is_packed(const uint8_t* data);
+
+/**
+ * Parse and validate packed file header
+ * @param data First PACKED_FILE_HEADER_SIZE bytes of the file
+ * @param header Output header
+ * @return true if the header is valid and within the supported limits
+ */
+bool packed_file_parse_header(const uint8_t* data, PackedFileHeader* header);
+
+/**
+ * Decompress one LZ4 block
+ * Every match and literal run is bounds checked, corrupt input fails
+ * instead of overrunning the buffers
+ * @param src Compressed block
+ * @param src_size Compressed size
+ * @param dst Output buffer
+ * @param dst_size Expected uncompressed size
+ * @return true if exactly dst_size bytes were decoded
+ */
+bool packed_file_decompress(
+    const uint8_t* src,
+    uint32_t src_size,
+    uint8_t* dst,
+    uint32_t dst_size);
@@ -0,0 +1,339 @@
+#include "prefetcher.h"
+#include <string.h>
+
+#define TAG "Prefetcher"
+
+// Worker thread events
+typedef enum {
+    PrefetcherEventWork = (1 << 0),
+    PrefetcherEventExit = (1 << 1),
+} PrefetcherEventFlag;
+
+typedef enum {
+    PrefetcherSlotFree,
+    PrefetcherSlotPending, // Being read by the worker
+    PrefetcherSlotReady,
+} PrefetcherSlotState;
+
+typedef struct {
+    PrefetcherSlotState state;
+    bool used; // Served at least one read
+    uint32_t lba;
+    uint32_t count;
+    uint8_t* data;
+} PrefetcherSlot;
+
+typedef struct {
+    BlockDevice* base;
+    BlockDeviceGeometry geometry;
+
+    FuriThread* thread;
+    FuriMutex* mutex; // Guards the ring and stream state
+    FuriMutex* base_mutex; // Serializes base reads between the worker and the host
+    FuriSemaphore* slot_done; // Released whenever a pending slot completes
+
+    PrefetcherSlot slots[PREFETCHER_SLOTS];
+    uint8_t* buffer; // Backing memory of all slots
+
+    // Stream state
+    uint32_t stream_lba; // Lowest block the host still needs
+    uint32_t fetch_lba; // Next block for the worker
+    uint32_t window_end; // Worker stops here
+    uint32_t next_hint_lba; // Start of the next command if the host streams
+    uint32_t last_hint_tick;
+    uint8_t depth; // Slots the worker may hold ahead of the host
+    bool cold_start; // Command did not continue the stream, its first wait is expected
+
+    // Statistics
+    uint32_t hits; // Reads served from the ring
+    uint32_t waits; // Reads that waited for the worker
+    uint32_t misses; // Reads that went to the base device
+    uint32_t wasted; // Slots dropped without being read
+} Prefetcher;
+
+static uint32_t slot_end(const PrefetcherSlot* slot) {
+    return slot->lba + slot->count;
+}
+
+// Slot holding lba, resident or in flight (NULL if none), mutex held
+static PrefetcherSlot* prefetcher_find_slot(Prefetcher* prefetcher, uint32_t lba) {
+    for(uint8_t i = 0; i < PREFETCHER_SLOTS; i++) {
+        PrefetcherSlot* slot = &prefetcher->slots[i];
+        if(slot->state != PrefetcherSlotFree && lba >= slot->lba && lba < slot_end(slot)) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+// Pick the next run for the worker and mark its slot pending, NULL if the
+// window is done or the worker is depth slots ahead of the host
+static PrefetcherSlot* prefetcher_claim_slot(Prefetcher* prefetcher) {
+    furi_mutex_acquire(prefetcher->mutex, FuriWaitForever);
+
+    // Never fetch what the host already has, nor what is resident or in flight
+    if(prefetcher->fetch_lba < prefetcher->stream_lba) {
+        prefetcher->fetch_lba = prefetcher->stream_lba;
+    }
+    PrefetcherSlot* covering;
+    while(prefetcher->fetch_lba < prefetcher->window_end &&
+          (covering = prefetcher_find_slot(prefetcher, prefetcher->fetch_lba)) != NULL) {
+        prefetcher->fetch_lba = slot_end(covering);
+    }
+
+    PrefetcherSlot* claimed = NULL;
+
+    if(prefetcher->fetch_lba < prefetcher->window_end) {
+        uint8_t ahead = 0;
+        PrefetcherSlot* free_slot = NULL;
+        PrefetcherSlot* stale_slot = NULL;
+
+        for(uint8_t i = 0; i < PREFETCHER_SLOTS; i++) {
+            PrefetcherSlot* slot = &prefetcher->slots[i];
+            if(slot->state == PrefetcherSlotFree) {
+                if(free_slot == NULL) free_slot = slot;
+            } else if(
+                slot_end(slot) <= prefetcher->stream_lba ||
+                slot->lba >= prefetcher->window_end) {
+                // Behind the host or outside the window, will not be read
+                if(slot->state == PrefetcherSlotReady && stale_slot == NULL) stale_slot = slot;
+            } else {
+                ahead++;
+            }
+        }
+
+        if(free_slot == NULL && stale_slot != NULL && ahead < prefetcher->depth) {
+            if(!stale_slot->used) {
+                // Read ahead for nothing, be less eager
+                prefetcher->wasted++;
+                if(prefetcher->depth > 1) prefetcher->depth--;
+            }
+            free_slot = stale_slot;
+        }
+
+        if(free_slot != NULL && ahead < prefetcher->depth) {
+            uint32_t count = prefetcher->window_end - prefetcher->fetch_lba;
+            if(count > PREFETCHER_SLOT_BLOCKS) count = PREFETCHER_SLOT_BLOCKS;
+
+            free_slot->state = PrefetcherSlotPending;
+            free_slot->used = false;
+            free_slot->lba = prefetcher->fetch_lba;
+            free_slot->count = count;
+            prefetcher->fetch_lba += count;
+            claimed = free_slot;
+        }
+    }
+
+    furi_mutex_release(prefetcher->mutex);
+    return claimed;
+}
+
+static int32_t prefetcher_worker(void* context) {
+    Prefetcher* prefetcher = context;
+
+    while(true) {
+        uint32_t flags = furi_thread_flags_wait(
+            PrefetcherEventWork | PrefetcherEventExit, FuriFlagWaitAny, FuriWaitForever);
+        if(flags & PrefetcherEventExit) break;
+
+        PrefetcherSlot* slot;
+        while((slot = prefetcher_claim_slot(prefetcher)) != NULL) {
+            furi_mutex_acquire(prefetcher->base_mutex, FuriWaitForever);
+            bool success =
+                block_device_read_blocks(prefetcher->base, slot->lba, slot->count, slot->data);
+            furi_mutex_release(prefetcher->base_mutex);
+
+            // A failed run is left to the host, which reads it again and reports the error
+            furi_mutex_acquire(prefetcher->mutex, FuriWaitForever);
+            slot->state = success ? PrefetcherSlotReady : PrefetcherSlotFree;
+            furi_mutex_release(prefetcher->mutex);
+
+            furi_semaphore_release(prefetcher->slot_done);
+        }
+    }
+
+    return 0;
+}
+
+static void prefetcher_wake(Prefetcher* prefetcher) {
+    furi_thread_flags_set(furi_thread_get_id(prefetcher->thread), PrefetcherEventWork);
+}
+
+static bool prefetcher_get_geometry(void* context, BlockDeviceGeometry* geometry) {
+    Prefetcher* prefetcher = context;
+    *geometry = prefetcher->geometry;
+    return true;
+}
+
+static bool prefetcher_read(void* context, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    Prefetcher* prefetcher = context;
+    uint32_t block_size = prefetcher->geometry.block_size;
+    bool waited = false;
+
+    while(count > 0) {
+        furi_mutex_acquire(prefetcher->mutex, FuriWaitForever);
+        PrefetcherSlot* slot = prefetcher_find_slot(prefetcher, lba);
+
+        if(slot != NULL && slot->state == PrefetcherSlotReady) {
+            uint32_t run = slot_end(slot) - lba;
+            if(run > count) run = count;
+
+            memcpy(buffer, slot->data + (lba - slot->lba) * block_size, run * block_size);
+            slot->used = true;
+            // Fully consumed slots go back to the worker
+            if(lba + run == slot_end(slot)) slot->state = PrefetcherSlotFree;
+
+            prefetcher->hits++;
+            lba += run;
+            count -= run;
+            buffer += run * block_size;
+            prefetcher->stream_lba = lba;
+            furi_mutex_release(prefetcher->mutex);
+            continue;
+        }
+
+        if(slot != NULL) {
+            // In flight: the worker started too late, unless the command broke the stream
+            if(!waited) {
+                prefetcher->waits++;
+                if(!prefetcher->cold_start && prefetcher->depth < PREFETCHER_SLOTS) {
+                    prefetcher->depth++;
+                }
+                waited = true;
+            }
+            furi_mutex_release(prefetcher->mutex);
+
+            furi_semaphore_acquire(prefetcher->slot_done, FuriWaitForever);
+            continue;
+        }
+
+        // Not prefetched, read up to the next resident run directly
+        uint32_t run = count;
+        for(uint8_t i = 0; i < PREFETCHER_SLOTS; i++) {
+            PrefetcherSlot* other = &prefetcher->slots[i];
+            if(other->state != PrefetcherSlotFree && other->lba > lba && other->lba - lba < run) {
+                run = other->lba - lba;
+            }
+        }
+        prefetcher->misses++;
+        // Keep the worker from fetching the same run
+        if(prefetcher->fetch_lba < lba + run) prefetcher->fetch_lba = lba + run;
+        furi_mutex_release(prefetcher->mutex);
+
+        furi_mutex_acquire(prefetcher->base_mutex, FuriWaitForever);
+        bool success = block_device_read_blocks(prefetcher->base, lba, run, buffer);
+        furi_mutex_release(prefetcher->base_mutex);
+        if(!success) return false;
+
+        lba += run;
+        count -= run;
+        buffer += run * block_size;
+
+        furi_mutex_acquire(prefetcher->mutex, FuriWaitForever);
+        prefetcher->stream_lba = lba;
+        furi_mutex_release(prefetcher->mutex);
+    }
+
+    furi_mutex_acquire(prefetcher->mutex, FuriWaitForever);
+    prefetcher->cold_start = false;
+    furi_mutex_release(prefetcher->mutex);
+
+    // Slots were freed, let the worker refill them
+    prefetcher_wake(prefetcher);
+
+    return true;
+}
+
+static void prefetcher_prefetch(void* context, uint32_t lba, uint32_t count) {
+    Prefetcher* prefetcher = context;
+    uint32_t block_count = prefetcher->geometry.block_count;
+    if(lba >= block_count) return;
+    if(count > block_count - lba) count = block_count - lba;
+
+    furi_mutex_acquire(prefetcher->mutex, FuriWaitForever);
+
+    uint32_t now = furi_get_tick();
+    uint32_t gap = now - prefetcher->last_hint_tick;
+    prefetcher->last_hint_tick = now;
+
+    bool sequential = lba == prefetcher->next_hint_lba;
+    prefetcher->next_hint_lba = lba + count;
+    prefetcher->stream_lba = lba;
+    prefetcher->cold_start = !sequential;
+
+    // Only a tight sequential stream is read past the end of the command
+    uint32_t end = lba + count;
+    if(sequential && gap < furi_ms_to_ticks(PREFETCHER_STREAM_GAP_MS)) {
+        uint32_t ahead = prefetcher->depth * PREFETCHER_SLOT_BLOCKS;
+        end = ahead > block_count - end ? block_count : end + ahead;
+    }
+    prefetcher->window_end = end;
+
+    if(!sequential || prefetcher->fetch_lba < lba || prefetcher->fetch_lba > end) {
+        prefetcher->fetch_lba = lba;
+    }
+
+    furi_mutex_release(prefetcher->mutex);
+
+    prefetcher_wake(prefetcher);
+}
+
+static void prefetcher_free(void* context) {
+    Prefetcher* prefetcher = context;
+
+    furi_thread_flags_set(furi_thread_get_id(prefetcher->thread), PrefetcherEventExit);
+    furi_thread_join(prefetcher->thread);
+    furi_thread_free(prefetcher->thread);
+
+    FURI_LOG_I(
+        TAG,
+        "Stats: hits=%lu, waits=%lu, misses=%lu, wasted=%lu, depth=%u",
+        prefetcher->hits,
+        prefetcher->waits,
+        prefetcher->misses,
+        prefetcher->wasted,
+        prefetcher->depth);
+
+    furi_semaphore_free(prefetcher->slot_done);
+    furi_mutex_free(prefetcher->base_mutex);
+    furi_mutex_free(prefetcher->mutex);
+    free(prefetcher->buffer);
+    free(prefetcher);
+}
+
+static const BlockDeviceApi prefetcher_api = {
+    .get_geometry = prefetcher_get_geometry,
+    .read_blocks = prefetcher_read,
+    .write_blocks = NULL,
+    .prefetch = prefetcher_prefetch,
+    .free = prefetcher_free,
+};
+
+BlockDevice* prefetcher_alloc(BlockDevice* base) {
+    BlockDeviceGeometry geometry;
+    if(!block_device_get_geometry(base, &geometry)) return NULL;
+
+    Prefetcher* prefetcher = malloc(sizeof(Prefetcher));
+    memset(prefetcher, 0, sizeof(Prefetcher));
+
+    prefetcher->base = base;
+    prefetcher->geometry = geometry;
+    prefetcher->depth = 1;
+    prefetcher->next_hint_lba = UINT32_MAX;
+
+    size_t slot_size = PREFETCHER_SLOT_BLOCKS * geometry.block_size;
+    prefetcher->buffer = malloc(PREFETCHER_SLOTS * slot_size);
+    for(uint8_t i = 0; i < PREFETCHER_SLOTS; i++) {
+        prefetcher->slots[i].state = PrefetcherSlotFree;
+        prefetcher->slots[i].data = prefetcher->buffer + i * slot_size;
+    }
+
+    prefetcher->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    prefetcher->base_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    prefetcher->slot_done = furi_semaphore_alloc(PREFETCHER_SLOTS, 0);
+
+    prefetcher->thread = furi_thread_alloc_ex("Prefetcher", 2048, prefetcher_worker, prefetcher);
+    furi_thread_start(prefetcher->thread);
+
+    return block_device_alloc(&prefetcher_api, prefetcher);
+}
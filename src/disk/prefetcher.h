@@ -0,0 +1,36 @@
+#pragma once
+
+#include <furi.h>
+#include "block_device.h"
+
+/**
+ * Prefetcher - reads ahead of the host on a background thread
+ * READ_10 hints (block_device_prefetch) start a worker that fills a ring of
+ * block runs while the USB worker is still sending packets, so the next read
+ * usually finds its blocks resident. Sequential streams are read past the end
+ * of the current command, the read-ahead depth grows when the host has to
+ * wait for the worker and shrinks when read-ahead blocks go unused.
+ */
+
+// Blocks per ring slot, matches the SCSI staging run
+#ifndef PREFETCHER_SLOT_BLOCKS
+#define PREFETCHER_SLOT_BLOCKS 8
+#endif
+
+// Ring slots, RAM use is PREFETCHER_SLOTS * PREFETCHER_SLOT_BLOCKS blocks
+#ifndef PREFETCHER_SLOTS
+#define PREFETCHER_SLOTS 4
+#endif
+
+// Commands further apart than this are not treated as one stream, so
+// nothing is read past the end of the command
+#define PREFETCHER_STREAM_GAP_MS 50
+
+/**
+ * Allocate prefetcher on top of a block device
+ * Starts the worker thread, block_device_free stops it. The base device stays
+ * owned by the caller and is only read, so it must not change underneath.
+ * @param base Device to read ahead on (must outlive the prefetcher)
+ * @return BlockDevice instance (read-only), or NULL if the base geometry is unavailable
+ */
+BlockDevice* prefetcher_alloc(BlockDevice* base);
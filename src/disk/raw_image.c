@@ -0,0 +1,141 @@
+#include "raw_image.h"
+#include <string.h>
+
+#define TAG "RawImage"
+
+struct RawImage {
+    File* file; // Session-long handle, NULL until opened
+    uint32_t file_size;
+    uint32_t total_sectors;
+    uint32_t position; // Current file position, used to skip redundant seeks
+    struct {
+        uint32_t sd_opens; // storage_file_open calls
+        uint32_t sd_seeks; // storage_file_seek calls (non-sequential reads only)
+        uint32_t sd_reads; // storage_file_read calls
+        uint32_t sd_sectors; // Sectors served from the image
+    } stats; // Logged on free
+};
+
+RawImage* raw_image_alloc(void) {
+    RawImage* image = malloc(sizeof(RawImage));
+    memset(image, 0, sizeof(RawImage));
+    return image;
+}
+
+void raw_image_free(RawImage* image) {
+    if(image == NULL) return;
+
+    if(image->file != NULL) {
+        storage_file_close(image->file);
+        storage_file_free(image->file);
+    }
+
+    FURI_LOG_I(
+        TAG,
+        "SD stats: opens=%lu, seeks=%lu, reads=%lu, sectors=%lu",
+        image->stats.sd_opens,
+        image->stats.sd_seeks,
+        image->stats.sd_reads,
+        image->stats.sd_sectors);
+
+    free(image);
+}
+
+bool raw_image_open(RawImage* image, Storage* storage, const char* sd_path) {
+    if(image == NULL || image->file != NULL) return false;
+
+    File* file = storage_file_alloc(storage);
+    image->stats.sd_opens++;
+
+    if(!storage_file_open(file, sd_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        FURI_LOG_E(TAG, "Cannot open image: %s", sd_path);
+        storage_file_free(file);
+        return false;
+    }
+
+    // SD card files (FAT32/exFAT seeks) are addressed with 32-bit offsets
+    uint64_t file_size = storage_file_size(file);
+    if(file_size == 0 || file_size > UINT32_MAX) {
+        FURI_LOG_E(TAG, "Unsupported image size: %s", sd_path);
+        storage_file_close(file);
+        storage_file_free(file);
+        return false;
+    }
+
+    image->file = file;
+    image->file_size = (uint32_t)file_size;
+    image->total_sectors =
+        image->file_size / SECTOR_SIZE + (image->file_size % SECTOR_SIZE != 0 ? 1 : 0);
+    image->position = 0;
+
+    FURI_LOG_I(TAG, "Opened image %s, %lu sectors", sd_path, image->total_sectors);
+
+    return true;
+}
+
+bool raw_image_read_sectors(RawImage* image, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    if(image == NULL || image->file == NULL || buffer == NULL) return false;
+    if(lba >= image->total_sectors || count > image->total_sectors - lba) return false;
+
+    uint32_t offset = lba * SECTOR_SIZE;
+    uint32_t run_size = count * SECTOR_SIZE;
+
+    // Only the last sector can extend past the end of the file
+    uint32_t copy_size = run_size;
+    if((uint64_t)offset + copy_size > image->file_size) {
+        copy_size = image->file_size - offset;
+        memset(buffer + copy_size, 0, run_size - copy_size);
+    }
+
+    // Sequential reads continue where the previous one stopped
+    if(image->position != offset) {
+        image->stats.sd_seeks++;
+        if(!storage_file_seek(image->file, offset, true)) {
+            FURI_LOG_E(TAG, "SD seek failed: LBA %lu", lba);
+            // Position is unknown now, force a seek next time
+            image->position = UINT32_MAX;
+            return false;
+        }
+        image->position = offset;
+    }
+
+    image->stats.sd_reads++;
+    image->stats.sd_sectors += count;
+    size_t bytes_read = storage_file_read(image->file, buffer, copy_size);
+    image->position += bytes_read;
+
+    if(bytes_read != copy_size) {
+        FURI_LOG_W(
+            TAG, "SD read mismatch: expected %lu, got %u", copy_size, (unsigned int)bytes_read);
+        memset(buffer + bytes_read, 0, copy_size - bytes_read);
+    }
+
+    return true;
+}
+
+uint32_t raw_image_get_total_sectors(RawImage* image) {
+    return image ? image->total_sectors : 0;
+}
+
+static bool raw_image_block_get_geometry(void* context, BlockDeviceGeometry* geometry) {
+    geometry->block_count = raw_image_get_total_sectors(context);
+    geometry->block_size = SECTOR_SIZE;
+    return geometry->block_count != 0;
+}
+
+static bool raw_image_block_read(void* context, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    return raw_image_read_sectors(context, lba, count, buffer);
+}
+
+static const BlockDeviceApi raw_image_block_api = {
+    .get_geometry = raw_image_block_get_geometry,
+    .read_blocks = raw_image_block_read,
+    .write_blocks = NULL,
+    .prefetch = NULL,
+    .free = NULL,
+};
+
+BlockDevice* raw_image_block_device_alloc(RawImage* image) {
+    if(image == NULL) return NULL;
+    return block_device_alloc(&raw_image_block_api, image);
+}
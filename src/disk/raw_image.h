@@ -0,0 +1,61 @@
+#pragma once
+
+#include <furi.h>
+#include <storage/storage.h>
+#include "block_device.h"
+
+/**
+ * Raw disk image - serves a prebuilt image file from SD card byte-for-byte
+ * LBAs map directly onto file offsets, no metadata is generated
+ */
+
+typedef struct RawImage RawImage;
+
+/**
+ * Allocate raw disk image
+ * @return RawImage instance
+ */
+RawImage* raw_image_alloc(void);
+
+/**
+ * Free raw disk image, closes the image file
+ * @param image Instance
+ */
+void raw_image_free(RawImage* image);
+
+/**
+ * Open image file
+ * The file stays open until raw_image_free. A partial last sector is
+ * padded with zeros.
+ * @param image Instance
+ * @param storage Storage instance
+ * @param sd_path Path to image on SD card (e.g., "/ext/apps_data/boot2flipper/ipxe.usb")
+ * @return true on success
+ */
+bool raw_image_open(RawImage* image, Storage* storage, const char* sd_path);
+
+/**
+ * Read consecutive sectors from image
+ * The whole run is fetched with one SD read
+ * @param image Instance
+ * @param lba First Logical Block Address
+ * @param count Number of sectors to read
+ * @param buffer Output buffer (must be count * SECTOR_SIZE bytes)
+ * @return true on success
+ */
+bool raw_image_read_sectors(RawImage* image, uint32_t lba, uint32_t count, uint8_t* buffer);
+
+/**
+ * Get total sector count, derived from the image file size
+ * @param image Instance
+ * @return Total sectors (0 if no image is open)
+ */
+uint32_t raw_image_get_total_sectors(RawImage* image);
+
+/**
+ * Allocate block device serving the image
+ * Free with block_device_free, the image itself stays owned by the caller
+ * @param image Opened instance
+ * @return BlockDevice instance (read-only)
+ */
+BlockDevice* raw_image_block_device_alloc(RawImage* image);
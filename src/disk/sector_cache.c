@@ -0,0 +1,312 @@
+#include "sector_cache.h"
+#include <string.h>
+
+#define TAG "SectorCache"
+
+#define SECTOR_CACHE_NONE UINT16_MAX // End of a list or chain
+
+typedef struct {
+    uint32_t lba;
+    uint16_t prev; // LRU list, towards the most recently used end
+    uint16_t next; // LRU list, towards the least recently used end
+    uint16_t chain; // Next entry in the same hash bucket
+    bool pinned; // Not on the LRU list, never evicted
+} SectorCacheEntry;
+
+typedef struct {
+    uint32_t lba;
+    uint32_t count;
+} SectorCachePin;
+
+struct SectorCache {
+    BlockDevice* base;
+    uint32_t block_size;
+    uint32_t block_count;
+
+    SectorCacheEntry* entries;
+    uint8_t* data; // capacity blocks, entry i owns block i
+    uint16_t capacity;
+    uint16_t used; // Entries handed out so far, eviction starts once all are used
+
+    // LBA lookup, buckets hold the first entry of each chain
+    uint16_t* buckets;
+    uint16_t bucket_mask;
+
+    // Unpinned entries, most recently used first
+    uint16_t lru_head;
+    uint16_t lru_tail;
+
+    // Sequential stream seen through the prefetch hints
+    uint32_t stream_lba; // First block of the stream
+    uint32_t hint_lba; // Current command
+    uint32_t hint_end;
+    uint32_t fill_limit; // Stream blocks inserted before the rest passes through
+
+    SectorCachePin pins[SECTOR_CACHE_MAX_PINS];
+    uint8_t pin_count;
+    uint32_t pinned_blocks; // Sum of pinned range sizes
+
+    SectorCacheStats stats;
+};
+
+uint16_t sector_cache_budget(uint32_t block_size) {
+    size_t free_heap = memmgr_heap_get_max_free_block();
+    if(free_heap <= SECTOR_CACHE_HEAP_RESERVE) return 0;
+
+    // Block, entry and bucket per cached block
+    size_t block_cost = block_size + sizeof(SectorCacheEntry) + sizeof(uint16_t);
+    size_t blocks = (free_heap - SECTOR_CACHE_HEAP_RESERVE) / 2 / block_cost;
+
+    if(blocks < SECTOR_CACHE_MIN_BLOCKS) return 0;
+    if(blocks > SECTOR_CACHE_MAX_BLOCKS) blocks = SECTOR_CACHE_MAX_BLOCKS;
+    return (uint16_t)blocks;
+}
+
+SectorCache* sector_cache_alloc(BlockDevice* base, uint16_t max_blocks) {
+    BlockDeviceGeometry geometry;
+    if(max_blocks == 0 || !block_device_get_geometry(base, &geometry)) return NULL;
+    if(max_blocks == SECTOR_CACHE_NONE) max_blocks--; // Reserved as the list terminator
+
+    SectorCache* cache = malloc(sizeof(SectorCache));
+    memset(cache, 0, sizeof(SectorCache));
+
+    cache->base = base;
+    cache->block_size = geometry.block_size;
+    cache->block_count = geometry.block_count;
+    cache->capacity = max_blocks;
+    cache->fill_limit = max_blocks / SECTOR_CACHE_STREAM_SHARE;
+    cache->entries = malloc(sizeof(SectorCacheEntry) * max_blocks);
+    cache->data = malloc((size_t)max_blocks * geometry.block_size);
+
+    // Power of two buckets, consecutive LBAs land in consecutive buckets
+    uint32_t bucket_count = 1;
+    while(bucket_count < max_blocks) {
+        bucket_count <<= 1;
+    }
+    cache->bucket_mask = bucket_count - 1;
+    cache->buckets = malloc(sizeof(uint16_t) * bucket_count);
+    memset(cache->buckets, 0xFF, sizeof(uint16_t) * bucket_count);
+
+    cache->lru_head = SECTOR_CACHE_NONE;
+    cache->lru_tail = SECTOR_CACHE_NONE;
+
+    FURI_LOG_I(
+        TAG, "Allocated %u blocks (%lu bytes)", max_blocks, max_blocks * geometry.block_size);
+    return cache;
+}
+
+void sector_cache_free(SectorCache* cache) {
+    if(cache == NULL) return;
+
+    FURI_LOG_I(
+        TAG,
+        "Stats: hits=%lu, misses=%lu, evictions=%lu, bypassed=%lu, pinned=%u",
+        cache->stats.hits,
+        cache->stats.misses,
+        cache->stats.evictions,
+        cache->stats.bypassed,
+        cache->stats.pinned);
+
+    free(cache->buckets);
+    free(cache->data);
+    free(cache->entries);
+    free(cache);
+}
+
+bool sector_cache_pin(SectorCache* cache, uint32_t lba, uint32_t count) {
+    if(cache == NULL || count == 0) return false;
+
+    if(lba >= cache->block_count) return false;
+    if(count > cache->block_count - lba) count = cache->block_count - lba;
+
+    if(cache->pin_count >= SECTOR_CACHE_MAX_PINS ||
+       cache->pinned_blocks + count > cache->capacity / 2u) {
+        FURI_LOG_W(TAG, "Cannot pin %lu+%lu: pin budget exhausted", lba, count);
+        return false;
+    }
+
+    cache->pins[cache->pin_count].lba = lba;
+    cache->pins[cache->pin_count].count = count;
+    cache->pin_count++;
+    cache->pinned_blocks += count;
+
+    FURI_LOG_D(TAG, "Pinned %lu+%lu", lba, count);
+    return true;
+}
+
+static bool sector_cache_is_pinned(SectorCache* cache, uint32_t lba) {
+    for(uint8_t i = 0; i < cache->pin_count; i++) {
+        if(lba - cache->pins[i].lba < cache->pins[i].count) return true;
+    }
+    return false;
+}
+
+static uint16_t sector_cache_find(SectorCache* cache, uint32_t lba) {
+    uint16_t index = cache->buckets[lba & cache->bucket_mask];
+    while(index != SECTOR_CACHE_NONE && cache->entries[index].lba != lba) {
+        index = cache->entries[index].chain;
+    }
+    return index;
+}
+
+static void sector_cache_lru_unlink(SectorCache* cache, uint16_t index) {
+    SectorCacheEntry* entry = &cache->entries[index];
+
+    if(entry->prev != SECTOR_CACHE_NONE) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->lru_head = entry->next;
+    }
+
+    if(entry->next != SECTOR_CACHE_NONE) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->lru_tail = entry->prev;
+    }
+}
+
+static void sector_cache_lru_push(SectorCache* cache, uint16_t index) {
+    SectorCacheEntry* entry = &cache->entries[index];
+
+    entry->prev = SECTOR_CACHE_NONE;
+    entry->next = cache->lru_head;
+    if(cache->lru_head != SECTOR_CACHE_NONE) {
+        cache->entries[cache->lru_head].prev = index;
+    } else {
+        cache->lru_tail = index;
+    }
+    cache->lru_head = index;
+}
+
+static void sector_cache_unhash(SectorCache* cache, uint16_t index) {
+    uint16_t* link = &cache->buckets[cache->entries[index].lba & cache->bucket_mask];
+    while(*link != index) {
+        link = &cache->entries[*link].chain;
+    }
+    *link = cache->entries[index].chain;
+}
+
+// Entry for a new block: a never used one, else the least recently used one
+static uint16_t sector_cache_take_entry(SectorCache* cache) {
+    if(cache->used < cache->capacity) return cache->used++;
+
+    uint16_t index = cache->lru_tail;
+    if(index == SECTOR_CACHE_NONE) return SECTOR_CACHE_NONE;
+
+    sector_cache_lru_unlink(cache, index);
+    sector_cache_unhash(cache, index);
+    cache->stats.evictions++;
+    return index;
+}
+
+static void sector_cache_insert(SectorCache* cache, uint32_t lba, const uint8_t* block) {
+    uint16_t index = sector_cache_take_entry(cache);
+    if(index == SECTOR_CACHE_NONE) return;
+
+    SectorCacheEntry* entry = &cache->entries[index];
+    entry->lba = lba;
+    entry->pinned = sector_cache_is_pinned(cache, lba);
+    entry->chain = cache->buckets[lba & cache->bucket_mask];
+    cache->buckets[lba & cache->bucket_mask] = index;
+
+    if(entry->pinned) {
+        cache->stats.pinned++;
+    } else {
+        sector_cache_lru_push(cache, index);
+    }
+
+    memcpy(cache->data + (size_t)index * cache->block_size, block, cache->block_size);
+}
+
+static bool sector_cache_get_geometry(void* context, BlockDeviceGeometry* geometry) {
+    SectorCache* cache = context;
+    geometry->block_count = cache->block_count;
+    geometry->block_size = cache->block_size;
+    return true;
+}
+
+// Metadata is read in short or scattered commands, a long sequential stream is file data
+static bool sector_cache_should_fill(SectorCache* cache, uint32_t lba) {
+    bool streamed = lba - cache->hint_lba < cache->hint_end - cache->hint_lba &&
+                    lba - cache->stream_lba >= cache->fill_limit;
+    return !streamed || sector_cache_is_pinned(cache, lba);
+}
+
+static bool sector_cache_read(void* context, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    SectorCache* cache = context;
+    uint32_t done = 0;
+
+    while(done < count) {
+        uint16_t index = sector_cache_find(cache, lba + done);
+        if(index != SECTOR_CACHE_NONE) {
+            memcpy(
+                buffer + done * cache->block_size,
+                cache->data + (size_t)index * cache->block_size,
+                cache->block_size);
+            if(!cache->entries[index].pinned) {
+                sector_cache_lru_unlink(cache, index);
+                sector_cache_lru_push(cache, index);
+            }
+            cache->stats.hits++;
+            done++;
+            continue;
+        }
+
+        // Read the whole run of missing blocks in one base call
+        uint32_t run = 1;
+        while(done + run < count &&
+              sector_cache_find(cache, lba + done + run) == SECTOR_CACHE_NONE) {
+            run++;
+        }
+
+        uint8_t* run_buffer = buffer + done * cache->block_size;
+        if(!block_device_read_blocks(cache->base, lba + done, run, run_buffer)) return false;
+
+        for(uint32_t i = 0; i < run; i++) {
+            if(sector_cache_should_fill(cache, lba + done + i)) {
+                sector_cache_insert(cache, lba + done + i, run_buffer + i * cache->block_size);
+            } else {
+                cache->stats.bypassed++;
+            }
+        }
+        cache->stats.misses += run;
+        done += run;
+    }
+
+    return true;
+}
+
+static void sector_cache_prefetch(void* context, uint32_t lba, uint32_t count) {
+    SectorCache* cache = context;
+
+    // A command that continues the previous one extends its stream
+    if(lba != cache->hint_end) cache->stream_lba = lba;
+    cache->hint_lba = lba;
+    cache->hint_end = lba + count;
+
+    // Only pass the hint on if the base will actually be read
+    for(uint32_t i = 0; i < count; i++) {
+        if(sector_cache_find(cache, lba + i) == SECTOR_CACHE_NONE) {
+            block_device_prefetch(cache->base, lba + i, count - i);
+            return;
+        }
+    }
+}
+
+static const BlockDeviceApi sector_cache_block_api = {
+    .get_geometry = sector_cache_get_geometry,
+    .read_blocks = sector_cache_read,
+    .write_blocks = NULL,
+    .prefetch = sector_cache_prefetch,
+    .free = NULL,
+};
+
+BlockDevice* sector_cache_block_device_alloc(SectorCache* cache) {
+    if(cache == NULL) return NULL;
+    return block_device_alloc(&sector_cache_block_api, cache);
+}
+
+void sector_cache_get_stats(SectorCache* cache, SectorCacheStats* stats) {
+    if(cache == NULL || stats == NULL) return;
+    *stats = cache->stats;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <furi.h>
+#include "block_device.h"
+
+/**
+ * Sector cache - fixed-budget LRU block cache on top of a block device
+ * Firmware and OS probers re-read the same blocks (partition tables, boot
+ * sector, FAT head, directories, PE headers) many times per boot. Hits are
+ * served from RAM, misses are read from the base in runs and inserted,
+ * evicting the least recently used block. Sequential streams are detected from
+ * the READ_10 hints; past their head they pass through (file data), so they do
+ * not flush the metadata. Pinned ranges are never evicted.
+ */
+
+// Upper bound of the cache size (128KB of 512-byte blocks)
+#define SECTOR_CACHE_MAX_BLOCKS 256
+
+// Smaller budgets are not worth the bookkeeping, sector_cache_budget returns 0
+#define SECTOR_CACHE_MIN_BLOCKS 16
+
+// Heap left alone when sizing the cache (USB stack, overlay, UI)
+#define SECTOR_CACHE_HEAP_RESERVE (32 * 1024)
+
+// Pinned ranges per cache, pinned blocks may use at most half the cache
+#define SECTOR_CACHE_MAX_PINS 16
+
+// A sequential stream fills at most 1/SECTOR_CACHE_STREAM_SHARE of the cache, the
+// rest of it is read without being inserted
+#define SECTOR_CACHE_STREAM_SHARE 4
+
+typedef struct SectorCache SectorCache;
+
+/**
+ * Sector cache statistics
+ */
+typedef struct {
+    uint32_t hits; // Blocks served from the cache
+    uint32_t misses; // Blocks read from the base device
+    uint32_t evictions; // Blocks dropped to make room
+    uint32_t bypassed; // Missed blocks of long streams, read without being inserted
+    uint16_t pinned; // Pinned blocks currently resident
+} SectorCacheStats;
+
+/**
+ * Compute cache size from the heap available right now
+ * Uses half of the largest free heap block beyond SECTOR_CACHE_HEAP_RESERVE,
+ * so it should be called once at session start, after the backend is set up.
+ * @param block_size Block size of the device to cache
+ * @return Cache size in blocks (at most SECTOR_CACHE_MAX_BLOCKS), or 0 if
+ *         less than SECTOR_CACHE_MIN_BLOCKS fit
+ */
+uint16_t sector_cache_budget(uint32_t block_size);
+
+/**
+ * Allocate sector cache
+ * All block buffers are allocated up front
+ * @param base Device to cache (must outlive the cache and must not change underneath)
+ * @param max_blocks Cache size in blocks
+ * @return SectorCache instance, or NULL if max_blocks is 0 or the base
+ *         geometry is unavailable
+ */
+SectorCache* sector_cache_alloc(BlockDevice* base, uint16_t max_blocks);
+
+/**
+ * Free sector cache
+ * @param cache Instance
+ */
+void sector_cache_free(SectorCache* cache);
+
+/**
+ * Pin a block range
+ * Blocks of the range are kept once read, LRU eviction skips them.
+ * @param cache Instance
+ * @param lba First Logical Block Address
+ * @param count Number of blocks
+ * @return true if pinned, false if out of pin slots or over the pin budget
+ */
+bool sector_cache_pin(SectorCache* cache, uint32_t lba, uint32_t count);
+
+/**
+ * Allocate block device serving the cache
+ * Free with block_device_free, the cache itself stays owned by the caller
+ * @param cache Instance
+ * @return BlockDevice instance (read-only)
+ */
+BlockDevice* sector_cache_block_device_alloc(SectorCache* cache);
+
+/**
+ * Get cache statistics
+ * @param cache Instance
+ * @param stats Output statistics
+ */
+void sector_cache_get_stats(SectorCache* cache, SectorCacheStats* stats);
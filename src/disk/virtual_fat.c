@@ -2,32 +2,181 @@
 #include "crc32.h"
 #include "mbr.h"
 #include "gpt.h"
+#include "packed_file.h"
 #include <storage/storage.h>
 #include <ctype.h>
 
 #define TAG       "VirtualFAT"
-#define MAX_FILES 16
+#define MAX_FILES 1024 // File table grows on demand up to this many entries
+
+// Initial allocation sizes, both grow by doubling
+#define FILE_TABLE_INITIAL  16
+#define STRING_POOL_INITIAL 256
+
+// Open SD file handles kept at once, least recently used is closed first
+#define SD_HANDLE_SLOTS 4
+
+// Disk growth is rounded up to 1MB steps
+#define DISK_SIZE_ALIGNMENT 2048
+#define DISK_GROW_ATTEMPTS  8
 
 // VFAT Long Filename (LFN) support
 #define LFN_ATTR 0x0F // LFN attribute (read-only + system + hidden + volume)
 #define LFN_LAST 0x40 // Last LFN entry flag
 
+#define DIR_ENTRIES_PER_SECTOR (SECTOR_SIZE / 32)
+#define ROOT_INDEX             UINT16_MAX // Extent file_index of the FAT32 root directory
+
+// Contiguous cluster range owned by one file or directory
+typedef struct {
+    uint32_t start_cluster;
+    uint32_t cluster_count;
+    uint16_t file_index;
+} VirtualFatExtent;
+
+// Metadata cache index entry, maps an LBA to a rendered sector in the pool
+typedef struct {
+    uint32_t lba;
+    uint16_t slot;
+} VirtualFatMetadataEntry;
+
+// Open SD file, shared by whichever file used it last
+typedef struct {
+    File* file;
+    int16_t file_index; // -1 if the slot is free
+    uint32_t position; // Current position, used to skip redundant seeks
+    uint32_t last_used;
+} VirtualFatHandle;
+
+// Decoded block of a packed SD file, one block of one file at a time
+typedef struct {
+    int16_t file_index; // File whose index is loaded, -1 if none
+    PackedFileHeader header;
+    uint32_t* offsets; // Block offsets in the SD file (block_count + 1)
+    int32_t block; // Block held in data, -1 if none
+    uint8_t* data; // Decoded block
+    uint8_t* input; // Packed block, read from SD
+    uint32_t buffer_size; // Size of data and input, largest registered block size
+} VirtualFatPackedCache;
+
+// Disk layout, resolved at seal time from payload, partition scheme, FAT type and cluster size
+typedef struct {
+    VirtualFatType fat_type;
+    uint8_t sectors_per_cluster;
+    uint32_t total_sectors;
+    uint32_t partition_sectors;
+    uint32_t reserved_sectors;
+    uint32_t fat_size; // Sectors per FAT copy
+    uint32_t root_dir_sectors; // Fixed root directory region (0 for FAT32)
+    uint32_t root_cluster; // Root directory cluster (0 for FAT12/FAT16)
+    uint32_t cluster_count; // Data clusters (excluding reserved entries 0 and 1)
+    uint32_t fat1_start;
+    uint32_t fat2_start;
+    uint32_t root_start; // First sector of the root directory region (FAT12/FAT16)
+    uint32_t data_start;
+} VirtualFatLayout;
+
 struct VirtualFat {
-    VirtualFatFile files[MAX_FILES];
-    uint8_t file_count;
+    VirtualFatFile* files;
+    uint16_t file_count;
+    uint16_t file_capacity;
+
+    // Long names and SD paths, offset 0 is the empty string
+    char* string_pool;
+    uint32_t string_pool_size;
+    uint32_t string_pool_capacity;
+
     uint32_t next_cluster;
+    uint32_t min_total_sectors; // Requested disk size floor (0 = scheme default)
+    VirtualFatType fat_type; // Requested FAT type (VIRTUAL_FAT_TYPE_AUTO = pick)
+    uint8_t sectors_per_cluster; // Requested cluster size (SECTORS_PER_CLUSTER_AUTO = pick)
+    VirtualFatLayout layout; // Valid once sealed
+
+    // Extent index, built by virtual_fat_seal (sorted by start_cluster)
+    bool sealed;
+    VirtualFatExtent* extents;
+    uint16_t extent_count;
+    uint16_t last_extent; // Last hit, sequential reads resolve without searching
+
+    // Directory listing index, built by virtual_fat_seal
+    // children groups file indices by parent (root first, registration order
+    // within a group), group of directory d spans child_start[d + 1] up to
+    // child_start[d + 2]. child_slot is the first entry slot of each child.
+    uint16_t* children;
+    uint16_t* child_start;
+    uint32_t* child_slot;
+
     PartitionScheme partition_scheme;
     VirtualFatFileReadCallback read_callback;
     void* callback_context;
+    VirtualFatStats stats;
+
+    // Session-long SD handles, opened lazily
+    VirtualFatHandle handles[SD_HANDLE_SLOTS];
+    uint32_t handle_clock;
+
+    // Packed files, buffers allocated on first read
+    VirtualFatPackedCache packed;
+
+    // GPT sectors, rendered once at seal time (NULL in MBR mode)
+    uint8_t* gpt_cache;
+
+    // Metadata sectors rendered at seal time (index sorted by LBA)
+    VirtualFatMetadataEntry* metadata_index;
+    uint16_t metadata_count;
+    uint8_t* metadata_sectors; // Pool of unique rendered sectors
+    size_t metadata_cache_limit;
 };
 
+// Sector offsets within gpt_cache
+#define GPT_CACHE_HEADER        0
+#define GPT_CACHE_PARTITIONS    1
+#define GPT_CACHE_BACKUP_HEADER 2
+#define GPT_CACHE_SECTORS       3
+
+// Render primary/backup GPT headers and the partition entry sector once
+// The partition array CRC is computed a single time and shared by both headers
+static void build_gpt_cache(VirtualFat* vfat) {
+    if(vfat->partition_scheme != PARTITION_SCHEME_GPT_ONLY) return;
+
+    const VirtualFatLayout* layout = &vfat->layout;
+    vfat->gpt_cache = malloc(GPT_CACHE_SECTORS * SECTOR_SIZE);
+
+    uint8_t* header = vfat->gpt_cache + GPT_CACHE_HEADER * SECTOR_SIZE;
+    uint8_t* partitions = vfat->gpt_cache + GPT_CACHE_PARTITIONS * SECTOR_SIZE;
+    uint8_t* backup_header = vfat->gpt_cache + GPT_CACHE_BACKUP_HEADER * SECTOR_SIZE;
+
+    uint32_t array_crc = gpt_partition_array_crc(PARTITION_START, layout->partition_sectors);
+    generate_gpt_header(header, layout->total_sectors, array_crc);
+    generate_gpt_partitions(partitions, PARTITION_START, layout->partition_sectors);
+    generate_gpt_backup_header(backup_header, layout->total_sectors, array_crc);
+
+    FURI_LOG_D(TAG, "GPT cache built, array CRC32: 0x%08lX", array_crc);
+}
+
 VirtualFat* virtual_fat_alloc(void) {
     VirtualFat* vfat = malloc(sizeof(VirtualFat));
     memset(vfat, 0, sizeof(VirtualFat));
 
+    vfat->file_capacity = FILE_TABLE_INITIAL;
+    vfat->files = malloc(sizeof(VirtualFatFile) * vfat->file_capacity);
     vfat->file_count = 0;
+
+    vfat->string_pool_capacity = STRING_POOL_INITIAL;
+    vfat->string_pool = malloc(vfat->string_pool_capacity);
+    vfat->string_pool[0] = '\0';
+    vfat->string_pool_size = 1;
+
+    for(uint8_t i = 0; i < SD_HANDLE_SLOTS; i++) {
+        vfat->handles[i].file_index = -1;
+    }
+    vfat->packed.file_index = -1;
+    vfat->packed.block = -1;
+
     vfat->partition_scheme = PARTITION_SCHEME_GPT_ONLY; // Default: GPT (UEFI)
-    vfat->next_cluster = 3; // Cluster 2 is root directory, files start at cluster 3
+    vfat->fat_type = VIRTUAL_FAT_TYPE_AUTO;
+    vfat->sectors_per_cluster = SECTORS_PER_CLUSTER_AUTO;
+    vfat->metadata_cache_limit = VIRTUAL_FAT_METADATA_CACHE_LIMIT;
 
     return vfat;
 }
@@ -36,98 +185,229 @@ void virtual_fat_free(VirtualFat* vfat) {
     if(vfat == NULL) return;
 
     // Free file data
-    for(uint8_t i = 0; i < vfat->file_count; i++) {
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
         if(vfat->files[i].source_type == FILE_SOURCE_MEMORY &&
            vfat->files[i].memory_data != NULL) {
             free((void*)vfat->files[i].memory_data);
-        } else if(vfat->files[i].source_type == FILE_SOURCE_SD_CARD && vfat->files[i].sd_path != NULL) {
-            furi_string_free(vfat->files[i].sd_path);
         }
     }
 
+    // Close session-long SD handles
+    for(uint8_t i = 0; i < SD_HANDLE_SLOTS; i++) {
+        if(vfat->handles[i].file != NULL) {
+            storage_file_close(vfat->handles[i].file);
+            storage_file_free(vfat->handles[i].file);
+        }
+    }
+
+    free(vfat->files);
+    free(vfat->string_pool);
+    free(vfat->extents);
+    free(vfat->children);
+    free(vfat->child_start);
+    free(vfat->child_slot);
+    free(vfat->gpt_cache);
+    free(vfat->metadata_index);
+    free(vfat->metadata_sectors);
+    free(vfat->packed.offsets);
+    free(vfat->packed.data);
+    free(vfat->packed.input);
+
+    FURI_LOG_I(
+        TAG,
+        "SD stats: opens=%lu, seeks=%lu, reads=%lu, sectors=%lu, packed blocks=%lu",
+        vfat->stats.sd_opens,
+        vfat->stats.sd_seeks,
+        vfat->stats.sd_reads,
+        vfat->stats.sd_sectors,
+        vfat->stats.packed_blocks);
+
     free(vfat);
 }
 
-bool virtual_fat_add_file(
-    VirtualFat* vfat,
-    const char* filename,
-    const uint8_t* data,
-    uint32_t size) {
-    if(vfat == NULL || vfat->file_count >= MAX_FILES) {
-        FURI_LOG_E(TAG, "Cannot add file: filesystem full");
-        return false;
+// Intern a string in the string pool, returns its offset
+static uint32_t pool_add(VirtualFat* vfat, const char* str, size_t len) {
+    if(len == 0) return 0;
+
+    if(vfat->string_pool_size + len + 1 > vfat->string_pool_capacity) {
+        while(vfat->string_pool_size + len + 1 > vfat->string_pool_capacity) {
+            vfat->string_pool_capacity *= 2;
+        }
+        vfat->string_pool = realloc(vfat->string_pool, vfat->string_pool_capacity);
     }
 
-    VirtualFatFile* file = &vfat->files[vfat->file_count];
+    uint32_t offset = vfat->string_pool_size;
+    memcpy(vfat->string_pool + offset, str, len);
+    vfat->string_pool[offset + len] = '\0';
+    vfat->string_pool_size += len + 1;
+
+    return offset;
+}
+
+static const char* pool_str(const VirtualFat* vfat, uint32_t offset) {
+    return vfat->string_pool + offset;
+}
+
+// Uppercase 8.3 character, anything not allowed in short names becomes '_'
+static char short_name_char(char c) {
+    if(c <= ' ' || strchr("\"*+,./:;<=>?[\\]|", c) != NULL) return '_';
+    return toupper(c);
+}
 
-    // Store long filename
-    size_t fn_len = strlen(filename);
-    if(fn_len >= sizeof(file->long_name)) fn_len = sizeof(file->long_name) - 1;
-    memcpy(file->long_name, filename, fn_len);
-    file->long_name[fn_len] = '\0';
+// Build the space padded, uppercase 8.3 name (last dot starts the extension)
+static void make_short_name(char* short_name, const char* name, size_t len) {
+    memset(short_name, ' ', 11);
 
-    // Parse filename to 8.3 format (for compatibility)
-    memset(file->name, ' ', 11);
+    const char* dot = NULL;
+    for(size_t i = 0; i < len; i++) {
+        if(name[i] == '.') dot = &name[i];
+    }
 
-    const char* dot = strrchr(filename, '.'); // Use last dot
-    size_t name_len = dot ? (size_t)(dot - filename) : strlen(filename);
+    size_t name_len = dot ? (size_t)(dot - name) : len;
     if(name_len > 8) name_len = 8;
 
     // Convert name to uppercase
     for(size_t i = 0; i < name_len; i++) {
-        file->name[i] = toupper(filename[i]);
+        short_name[i] = short_name_char(name[i]);
     }
 
-    if(dot && strlen(dot + 1) > 0) {
-        size_t ext_len = strlen(dot + 1);
+    // Name part must not be empty (".hidden")
+    if(name_len == 0) short_name[0] = '_';
+
+    if(dot) {
+        size_t ext_len = len - (dot + 1 - name);
         if(ext_len > 3) ext_len = 3;
         // Convert extension to uppercase
         for(size_t i = 0; i < ext_len; i++) {
-            file->name[8 + i] = toupper(dot[1 + i]);
+            short_name[8 + i] = short_name_char(dot[1 + i]);
         }
     }
+}
 
-    // Copy file data
-    file->memory_data = malloc(size);
-    memcpy((void*)file->memory_data, data, size);
-    file->size = size;
-    file->source_type = FILE_SOURCE_MEMORY;
-    file->is_directory = false;
-    file->parent_index = -1; // Root directory
-    file->start_cluster = vfat->next_cluster;
+static bool short_name_taken(VirtualFat* vfat, const char* short_name, int16_t parent_index) {
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        if(vfat->files[i].parent_index == parent_index &&
+           memcmp(vfat->files[i].name, short_name, 11) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    // Calculate clusters needed
-    uint32_t clusters_needed =
-        (size + (SECTORS_PER_CLUSTER * SECTOR_SIZE) - 1) / (SECTORS_PER_CLUSTER * SECTOR_SIZE);
-    vfat->next_cluster += clusters_needed;
+// Resolve 8.3 collisions between siblings with numeric tails (KERNEL~1.IMG)
+static void make_short_name_unique(VirtualFat* vfat, char* short_name, int16_t parent_index) {
+    if(!short_name_taken(vfat, short_name, parent_index)) return;
 
-    vfat->file_count++;
+    char base[8];
+    memcpy(base, short_name, 8);
+    size_t base_len = 8;
+    while(base_len > 1 && base[base_len - 1] == ' ')
+        base_len--;
 
-    FURI_LOG_I(
-        TAG,
-        "Added file: %.11s, size: %lu, cluster: %lu",
-        file->name,
-        file->size,
-        file->start_cluster);
+    // A directory never holds more than MAX_FILES entries, one tail always fits
+    for(uint16_t n = 1; n <= MAX_FILES; n++) {
+        char tail[8];
+        size_t tail_len = snprintf(tail, sizeof(tail), "~%u", n);
+        size_t keep = MIN(base_len, 8 - tail_len);
 
-    return true;
+        memset(short_name, ' ', 8);
+        memcpy(short_name, base, keep);
+        memcpy(short_name + keep, tail, tail_len);
+
+        if(!short_name_taken(vfat, short_name, parent_index)) return;
+    }
 }
 
-bool virtual_fat_add_text_file(VirtualFat* vfat, const char* filename, const char* text) {
-    return virtual_fat_add_file(vfat, filename, (const uint8_t*)text, strlen(text));
+// Case-insensitive long name comparison, FAT names are case preserving only
+static bool long_name_equals(const char* long_name, const char* name, size_t len) {
+    for(size_t i = 0; i < len; i++) {
+        if(long_name[i] == '\0' || toupper(long_name[i]) != toupper(name[i])) return false;
+    }
+    return long_name[len] == '\0';
 }
 
-bool virtual_fat_add_sd_file(
-    Storage* storage,
+// Find an entry by name in parent, -1 if there is none
+static int16_t find_entry(VirtualFat* vfat, const char* name, size_t len, int16_t parent_index) {
+    if(len > 255) len = 255;
+
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        if(vfat->files[i].parent_index == parent_index &&
+           long_name_equals(pool_str(vfat, vfat->files[i].long_name), name, len)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Append a table entry named after name[0..len), growing the table if needed
+// Returns its index, or -1 when the filesystem is full or the name is taken
+static int16_t add_entry(
     VirtualFat* vfat,
-    const char* filename,
-    const char* sd_path) {
-    if(vfat == NULL || vfat->file_count >= MAX_FILES) {
-        FURI_LOG_E(TAG, "Cannot add SD file: filesystem full");
-        return false;
+    const char* name,
+    size_t len,
+    bool is_directory,
+    int16_t parent_index) {
+    if(vfat->file_count >= MAX_FILES) {
+        FURI_LOG_E(TAG, "Filesystem full (%u entries)", MAX_FILES);
+        return -1;
     }
 
-    // Open SD file to get size
+    // Long names are limited to 255 characters (VFAT)
+    if(len > 255) len = 255;
+
+    if(find_entry(vfat, name, len, parent_index) >= 0) {
+        FURI_LOG_W(TAG, "Name already exists: %.*s", (int)len, name);
+        return -1;
+    }
+
+    if(vfat->file_count == vfat->file_capacity) {
+        vfat->file_capacity *= 2;
+        vfat->files = realloc(vfat->files, sizeof(VirtualFatFile) * vfat->file_capacity);
+    }
+
+    int16_t index = vfat->file_count;
+    VirtualFatFile* entry = &vfat->files[index];
+    memset(entry, 0, sizeof(VirtualFatFile));
+
+    make_short_name(entry->name, name, len);
+    make_short_name_unique(vfat, entry->name, parent_index);
+    entry->long_name = pool_add(vfat, name, len);
+    entry->source_type = FILE_SOURCE_MEMORY;
+    entry->is_directory = is_directory;
+    entry->parent_index = parent_index;
+
+    vfat->file_count++;
+
+    return index;
+}
+
+// Register an SD card file under parent_index, size and source come from the caller
+static bool add_sd_entry(
+    VirtualFat* vfat,
+    const char* filename,
+    const char* sd_path,
+    uint64_t file_size,
+    FileSourceType source_type,
+    int16_t parent_index) {
+    int16_t index = add_entry(vfat, filename, strlen(filename), false, parent_index);
+    if(index < 0) return false;
+
+    VirtualFatFile* vfat_file = &vfat->files[index];
+    vfat_file->sd_path = pool_add(vfat, sd_path, strlen(sd_path));
+    vfat_file->size = (uint32_t)file_size;
+    vfat_file->source_type = source_type;
+
+    return true;
+}
+
+// Get file size and source type without keeping the file open
+// Packed files report their uncompressed size
+static bool get_sd_file_size(
+    Storage* storage,
+    VirtualFat* vfat,
+    const char* sd_path,
+    uint64_t* file_size,
+    FileSourceType* source_type) {
     File* file = storage_file_alloc(storage);
 
     if(!storage_file_open(file, sd_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
@@ -136,140 +416,137 @@ bool virtual_fat_add_sd_file(
         return false;
     }
 
-    uint64_t file_size = storage_file_size(file);
+    *file_size = storage_file_size(file);
+    *source_type = FILE_SOURCE_SD_CARD;
+
+    uint8_t header_data[PACKED_FILE_HEADER_SIZE];
+    bool success = true;
+
+    if(*file_size >= PACKED_FILE_HEADER_SIZE &&
+       storage_file_read(file, header_data, PACKED_FILE_HEADER_SIZE) ==
+           PACKED_FILE_HEADER_SIZE &&
+       packed_file_is_packed(header_data)) {
+        PackedFileHeader header;
+        if(packed_file_parse_header(header_data, &header)) {
+            *file_size = header.size;
+            *source_type = FILE_SOURCE_SD_PACKED;
+            if(header.block_size > vfat->packed.buffer_size) {
+                vfat->packed.buffer_size = header.block_size;
+            }
+        } else {
+            FURI_LOG_E(TAG, "Unsupported packed file: %s", sd_path);
+            success = false;
+        }
+    }
+
     storage_file_close(file);
     storage_file_free(file);
 
-    VirtualFatFile* vfat_file = &vfat->files[vfat->file_count];
-
-    // Store long filename
-    size_t fn_len = strlen(filename);
-    if(fn_len >= sizeof(vfat_file->long_name)) fn_len = sizeof(vfat_file->long_name) - 1;
-    memcpy(vfat_file->long_name, filename, fn_len);
-    vfat_file->long_name[fn_len] = '\0';
-
-    // Parse filename to 8.3 format
-    memset(vfat_file->name, ' ', 11);
-
-    const char* dot = strrchr(filename, '.'); // Use last dot
-    size_t name_len = dot ? (size_t)(dot - filename) : strlen(filename);
-    if(name_len > 8) name_len = 8;
+    return success;
+}
 
-    // Convert to uppercase
-    for(size_t i = 0; i < name_len; i++) {
-        vfat_file->name[i] = toupper(filename[i]);
+bool virtual_fat_add_file(
+    VirtualFat* vfat,
+    const char* filename,
+    const uint8_t* data,
+    uint32_t size) {
+    if(vfat != NULL && vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot add file: filesystem already sealed");
+        return false;
     }
 
-    if(dot && strlen(dot + 1) > 0) {
-        size_t ext_len = strlen(dot + 1);
-        if(ext_len > 3) ext_len = 3;
-        for(size_t i = 0; i < ext_len; i++) {
-            vfat_file->name[8 + i] = toupper(dot[1 + i]);
-        }
+    int16_t index = vfat ? add_entry(vfat, filename, strlen(filename), false, -1) : -1;
+    if(index < 0) {
+        FURI_LOG_E(TAG, "Cannot add file: %s", filename);
+        return false;
     }
 
-    // Store SD path
-    vfat_file->sd_path = furi_string_alloc_set(sd_path);
-    vfat_file->size = (uint32_t)file_size;
-    vfat_file->source_type = FILE_SOURCE_SD_CARD;
-    vfat_file->is_directory = false;
-    vfat_file->parent_index = -1; // Root directory
-    vfat_file->start_cluster = vfat->next_cluster;
-
-    // Calculate clusters needed
-    uint32_t clusters_needed = (vfat_file->size + (SECTORS_PER_CLUSTER * SECTOR_SIZE) - 1) /
-                               (SECTORS_PER_CLUSTER * SECTOR_SIZE);
-    vfat->next_cluster += clusters_needed;
+    VirtualFatFile* file = &vfat->files[index];
 
-    vfat->file_count++;
+    // Copy file data
+    file->memory_data = malloc(size);
+    memcpy((void*)file->memory_data, data, size);
+    file->size = size;
 
-    FURI_LOG_I(
-        TAG,
-        "Added SD file: %.11s, size: %lu, cluster: %lu, path: %s",
-        vfat_file->name,
-        vfat_file->size,
-        vfat_file->start_cluster,
-        sd_path);
+    FURI_LOG_I(TAG, "Added file: %.11s, size: %lu", file->name, file->size);
 
     return true;
 }
 
-// Helper: Find directory by name in parent
-static int8_t find_directory(VirtualFat* vfat, const char* name, int8_t parent_index) {
-    char search_name[11];
-    memset(search_name, ' ', 11);
-
-    size_t name_len = strlen(name);
-    if(name_len > 8) name_len = 8;
+bool virtual_fat_add_text_file(VirtualFat* vfat, const char* filename, const char* text) {
+    return virtual_fat_add_file(vfat, filename, (const uint8_t*)text, strlen(text));
+}
 
-    for(size_t i = 0; i < name_len; i++) {
-        search_name[i] = toupper(name[i]);
+bool virtual_fat_add_sd_file(
+    Storage* storage,
+    VirtualFat* vfat,
+    const char* filename,
+    const char* sd_path) {
+    if(vfat != NULL && vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot add SD file: filesystem already sealed");
+        return false;
     }
 
-    for(uint8_t i = 0; i < vfat->file_count; i++) {
-        if(vfat->files[i].is_directory && vfat->files[i].parent_index == parent_index &&
-           memcmp(vfat->files[i].name, search_name, 11) == 0) {
-            return i;
-        }
+    if(vfat == NULL || vfat->file_count >= MAX_FILES) {
+        FURI_LOG_E(TAG, "Cannot add SD file: filesystem full");
+        return false;
     }
-    return -1;
-}
 
-bool virtual_fat_add_directory(VirtualFat* vfat, const char* dirname) {
-    if(vfat == NULL || vfat->file_count >= MAX_FILES) {
-        FURI_LOG_E(TAG, "Cannot add directory: filesystem full");
+    // Open SD file to get size
+    uint64_t file_size;
+    FileSourceType source_type;
+    if(!get_sd_file_size(storage, vfat, sd_path, &file_size, &source_type)) {
         return false;
     }
 
-    VirtualFatFile* dir = &vfat->files[vfat->file_count];
+    if(!add_sd_entry(vfat, filename, sd_path, file_size, source_type, -1)) {
+        FURI_LOG_E(TAG, "Cannot add SD file: %s", filename);
+        return false;
+    }
 
-    // Store long dirname
-    size_t dn_len = strlen(dirname);
-    if(dn_len >= sizeof(dir->long_name)) dn_len = sizeof(dir->long_name) - 1;
-    memcpy(dir->long_name, dirname, dn_len);
-    dir->long_name[dn_len] = '\0';
+    FURI_LOG_I(
+        TAG,
+        "Added SD file: %.11s, size: %lu, path: %s",
+        vfat->files[vfat->file_count - 1].name,
+        vfat->files[vfat->file_count - 1].size,
+        sd_path);
 
-    // Parse dirname to 8.3 format
-    memset(dir->name, ' ', 11);
+    return true;
+}
 
-    size_t name_len = strlen(dirname);
-    if(name_len > 8) name_len = 8;
+// Helper: Find directory by name in parent
+static int16_t
+    find_directory(VirtualFat* vfat, const char* name, size_t len, int16_t parent_index) {
+    int16_t index = find_entry(vfat, name, len, parent_index);
+    if(index >= 0 && !vfat->files[index].is_directory) return -1;
+    return index;
+}
 
-    // Convert to uppercase
-    for(size_t i = 0; i < name_len; i++) {
-        dir->name[i] = toupper(dirname[i]);
+bool virtual_fat_add_directory(VirtualFat* vfat, const char* dirname) {
+    if(vfat != NULL && vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot add directory: filesystem already sealed");
+        return false;
     }
 
-    dir->size = 0;
-    dir->source_type = FILE_SOURCE_MEMORY;
-    dir->memory_data = NULL;
-    dir->is_directory = true;
-    dir->parent_index = -1; // Root directory
-    dir->start_cluster = vfat->next_cluster;
-
-    // Directories take 1 cluster
-    vfat->next_cluster++;
-
-    vfat->file_count++;
+    int16_t index = vfat ? add_entry(vfat, dirname, strlen(dirname), true, -1) : -1;
+    if(index < 0) {
+        FURI_LOG_E(TAG, "Cannot add directory: %s", dirname);
+        return false;
+    }
 
-    FURI_LOG_I(TAG, "Added directory: %.11s, cluster: %lu", dir->name, dir->start_cluster);
+    FURI_LOG_I(TAG, "Added directory: %.11s", vfat->files[index].name);
 
     return true;
 }
 
 // Create nested directory path (e.g., "EFI/BOOT")
-static int8_t create_directory_path(VirtualFat* vfat, const char* path) {
+static int16_t create_directory_path(VirtualFat* vfat, const char* path) {
     if(path == NULL || strlen(path) == 0) return -1;
 
-    char path_copy[256];
-    strncpy(path_copy, path, sizeof(path_copy) - 1);
-    path_copy[sizeof(path_copy) - 1] = '\0';
-
-    int8_t current_parent = -1; // Start at root
+    int16_t current_parent = -1; // Start at root
 
     // Manual tokenization to avoid strtok (not available in Flipper API)
-    char* ptr = path_copy;
-    char token[64];
+    const char* ptr = path;
 
     while(*ptr != '\0') {
         // Skip leading slashes
@@ -278,57 +555,27 @@ static int8_t create_directory_path(VirtualFat* vfat, const char* path) {
         if(*ptr == '\0') break;
 
         // Extract token until next slash or end
-        size_t token_len = 0;
-        while(*ptr != '\0' && *ptr != '/' && token_len < sizeof(token) - 1) {
-            token[token_len++] = *ptr++;
-        }
-        token[token_len] = '\0';
-
-        if(token_len == 0) break;
+        const char* token = ptr;
+        while(*ptr != '\0' && *ptr != '/')
+            ptr++;
+        size_t token_len = ptr - token;
 
         // Check if directory already exists
-        int8_t dir_index = find_directory(vfat, token, current_parent);
+        int16_t dir_index = find_directory(vfat, token, token_len, current_parent);
 
         if(dir_index < 0) {
             // Create new directory
-            if(vfat->file_count >= MAX_FILES) {
-                FURI_LOG_E(TAG, "Cannot create directory: filesystem full");
+            dir_index = add_entry(vfat, token, token_len, true, current_parent);
+            if(dir_index < 0) {
+                FURI_LOG_E(TAG, "Cannot create directory: %.*s", (int)token_len, token);
                 return -1;
             }
 
-            VirtualFatFile* dir = &vfat->files[vfat->file_count];
-
-            // Store long name
-            if(token_len >= sizeof(dir->long_name)) token_len = sizeof(dir->long_name) - 1;
-            memcpy(dir->long_name, token, token_len);
-            dir->long_name[token_len] = '\0';
-
-            // Parse name to 8.3 format
-            memset(dir->name, ' ', 11);
-            size_t name_len = token_len;
-            if(name_len > 8) name_len = 8;
-
-            for(size_t i = 0; i < name_len; i++) {
-                dir->name[i] = toupper(token[i]);
-            }
-
-            dir->size = 0;
-            dir->source_type = FILE_SOURCE_MEMORY;
-            dir->memory_data = NULL;
-            dir->is_directory = true;
-            dir->parent_index = current_parent;
-            dir->start_cluster = vfat->next_cluster;
-
-            vfat->next_cluster++;
-            dir_index = vfat->file_count;
-            vfat->file_count++;
-
             FURI_LOG_I(
                 TAG,
-                "Created directory: %.11s (parent: %d, cluster: %lu)",
-                dir->name,
-                current_parent,
-                dir->start_cluster);
+                "Created directory: %.11s (parent: %d)",
+                vfat->files[dir_index].name,
+                current_parent);
         }
 
         current_parent = dir_index;
@@ -343,89 +590,199 @@ bool virtual_fat_add_file_to_subdir(
     const char* parent_dir,
     const char* filename,
     const char* sd_path) {
+    if(vfat != NULL && vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot add file to subdir: filesystem already sealed");
+        return false;
+    }
+
     if(vfat == NULL || vfat->file_count >= MAX_FILES) {
         FURI_LOG_E(TAG, "Cannot add file to subdir: filesystem full");
         return false;
     }
 
     // Create parent directory path if needed
-    int8_t parent_index = create_directory_path(vfat, parent_dir);
+    int16_t parent_index = create_directory_path(vfat, parent_dir);
     if(parent_index < 0) {
         FURI_LOG_E(TAG, "Failed to create parent directory: %s", parent_dir);
         return false;
     }
 
     // Open SD file to get size
-    File* file = storage_file_alloc(storage);
-    if(!storage_file_open(file, sd_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
-        FURI_LOG_E(TAG, "Cannot open SD file: %s", sd_path);
-        storage_file_free(file);
+    uint64_t file_size;
+    FileSourceType source_type;
+    if(!get_sd_file_size(storage, vfat, sd_path, &file_size, &source_type)) {
         return false;
     }
 
-    uint64_t file_size = storage_file_size(file);
-    storage_file_close(file);
-    storage_file_free(file);
+    if(!add_sd_entry(vfat, filename, sd_path, file_size, source_type, parent_index)) {
+        FURI_LOG_E(TAG, "Cannot add file to subdir: %s", filename);
+        return false;
+    }
 
-    VirtualFatFile* vfat_file = &vfat->files[vfat->file_count];
+    FURI_LOG_I(
+        TAG,
+        "Added file to subdir: %.11s, parent: %d, size: %lu",
+        vfat->files[vfat->file_count - 1].name,
+        parent_index,
+        vfat->files[vfat->file_count - 1].size);
 
-    // Store long filename
-    size_t fn_len = strlen(filename);
-    if(fn_len >= sizeof(vfat_file->long_name)) fn_len = sizeof(vfat_file->long_name) - 1;
-    memcpy(vfat_file->long_name, filename, fn_len);
-    vfat_file->long_name[fn_len] = '\0';
+    return true;
+}
 
-    // Parse filename to 8.3 format
-    memset(vfat_file->name, ' ', 11);
+// SD directory waiting to be scanned by virtual_fat_add_sd_tree
+typedef struct {
+    int16_t dir_index;
+    uint32_t sd_path; // String pool offset
+} VirtualFatPendingDir;
+
+typedef struct {
+    VirtualFatPendingDir* items;
+    uint16_t count;
+    uint16_t capacity;
+} VirtualFatDirQueue;
+
+static void dir_queue_push(VirtualFatDirQueue* queue, int16_t dir_index, uint32_t sd_path) {
+    if(queue->count == queue->capacity) {
+        queue->capacity = queue->capacity ? queue->capacity * 2 : 8;
+        queue->items = realloc(queue->items, sizeof(VirtualFatPendingDir) * queue->capacity);
+    }
+    queue->items[queue->count].dir_index = dir_index;
+    queue->items[queue->count].sd_path = sd_path;
+    queue->count++;
+}
 
-    const char* dot = strrchr(filename, '.'); // Use last dot
-    size_t name_len = dot ? (size_t)(dot - filename) : strlen(filename);
-    if(name_len > 8) name_len = 8;
+// Register the contents of one SD directory under parent_index
+// Sizes come from the directory listing, files are not opened. Subdirectories
+// are queued, directories that already exist in the volume are merged.
+static bool add_sd_directory_entries(
+    Storage* storage,
+    VirtualFat* vfat,
+    const char* sd_dir,
+    int16_t parent_index,
+    VirtualFatDirQueue* queue) {
+    File* dir = storage_file_alloc(storage);
+    if(!storage_dir_open(dir, sd_dir)) {
+        FURI_LOG_E(TAG, "Cannot open SD directory: %s", sd_dir);
+        storage_dir_close(dir);
+        storage_file_free(dir);
+        return false;
+    }
 
-    for(size_t i = 0; i < name_len; i++) {
-        vfat_file->name[i] = toupper(filename[i]);
+    FileInfo info;
+    char name[256];
+    FuriString* path = furi_string_alloc();
+    bool success = true;
+
+    while(storage_dir_read(dir, &info, name, sizeof(name))) {
+        // Hidden files (and macOS "._" metadata files) are not mirrored
+        if(name[0] == '.') continue;
+
+        if(vfat->file_count >= MAX_FILES) {
+            FURI_LOG_E(TAG, "Cannot mirror %s: filesystem full", sd_dir);
+            success = false;
+            break;
+        }
+
+        furi_string_printf(path, "%s/%s", sd_dir, name);
+
+        if(file_info_is_dir(&info)) {
+            int16_t index = find_directory(vfat, name, strlen(name), parent_index);
+            if(index < 0) index = add_entry(vfat, name, strlen(name), true, parent_index);
+            if(index < 0) continue; // A file has this name, add_entry warned
+
+            dir_queue_push(
+                queue, index, pool_add(vfat, furi_string_get_cstr(path), furi_string_size(path)));
+            continue;
+        }
+
+        if(info.size > UINT32_MAX) {
+            FURI_LOG_W(TAG, "Skipping %s: larger than 4GB", furi_string_get_cstr(path));
+            continue;
+        }
+
+        // Duplicate names are skipped, add_entry already warned about them
+        add_sd_entry(
+            vfat, name, furi_string_get_cstr(path), info.size, FILE_SOURCE_SD_CARD, parent_index);
     }
 
-    if(dot && strlen(dot + 1) > 0) {
-        size_t ext_len = strlen(dot + 1);
-        if(ext_len > 3) ext_len = 3;
-        for(size_t i = 0; i < ext_len; i++) {
-            vfat_file->name[8 + i] = toupper(dot[1 + i]);
+    furi_string_free(path);
+    storage_dir_close(dir);
+    storage_file_free(dir);
+
+    return success;
+}
+
+bool virtual_fat_add_sd_tree(
+    Storage* storage,
+    VirtualFat* vfat,
+    const char* sd_dir,
+    const char* mount_path) {
+    if(vfat != NULL && vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot add SD tree: filesystem already sealed");
+        return false;
+    }
+
+    if(vfat == NULL) return false;
+
+    // Empty mount path mirrors into the root directory
+    int16_t parent_index = -1;
+    if(mount_path != NULL && mount_path[0] != '\0') {
+        parent_index = create_directory_path(vfat, mount_path);
+        if(parent_index < 0) {
+            FURI_LOG_E(TAG, "Failed to create mount directory: %s", mount_path);
+            return false;
         }
     }
 
-    vfat_file->sd_path = furi_string_alloc_set(sd_path);
-    vfat_file->size = (uint32_t)file_size;
-    vfat_file->source_type = FILE_SOURCE_SD_CARD;
-    vfat_file->is_directory = false;
-    vfat_file->parent_index = parent_index;
-    vfat_file->start_cluster = vfat->next_cluster;
+    uint16_t first = vfat->file_count;
+    VirtualFatDirQueue queue = {0};
+    dir_queue_push(&queue, parent_index, pool_add(vfat, sd_dir, strlen(sd_dir)));
 
-    uint32_t clusters_needed = (vfat_file->size + (SECTORS_PER_CLUSTER * SECTOR_SIZE) - 1) /
-                               (SECTORS_PER_CLUSTER * SECTOR_SIZE);
-    vfat->next_cluster += clusters_needed;
+    // Breadth-first walk, one storage_dir_open per directory
+    FuriString* dir_path = furi_string_alloc();
+    bool success = true;
 
-    vfat->file_count++;
+    for(uint16_t i = 0; i < queue.count && success; i++) {
+        // Copy the path, the string pool may move while the directory is scanned
+        furi_string_set(dir_path, pool_str(vfat, queue.items[i].sd_path));
+        success = add_sd_directory_entries(
+            storage, vfat, furi_string_get_cstr(dir_path), queue.items[i].dir_index, &queue);
+    }
+
+    furi_string_free(dir_path);
+    free(queue.items);
 
     FURI_LOG_I(
-        TAG,
-        "Added file to subdir: %.11s, parent: %d, size: %lu, cluster: %lu",
-        vfat_file->name,
-        parent_index,
-        vfat_file->size,
-        vfat_file->start_cluster);
+        TAG, "Mirrored %s: %u entries", sd_dir, (unsigned int)(vfat->file_count - first));
 
-    return true;
+    return success;
 }
 
-static void generate_boot_sector(uint8_t* buffer, uint32_t total_sectors) {
+static void generate_boot_sector(uint8_t* buffer, const VirtualFatLayout* layout) {
+    uint32_t total_sectors = layout->partition_sectors;
+    uint32_t fat_size = layout->fat_size;
+    bool fat32 = layout->fat_type == VIRTUAL_FAT_TYPE_FAT32;
+
+    // FAT32 BPB is 28 bytes longer, boot code starts after it
+    uint8_t code_offset = fat32 ? 90 : 62;
+    uint8_t* ebpb = fat32 ? &buffer[64] : &buffer[36];
+
+    // FAT12/FAT16 keep small volumes in the 16-bit total sectors field
+    uint32_t small_sectors = (!fat32 && total_sectors <= 0xFFFF) ? total_sectors : 0;
+    uint32_t large_sectors = small_sectors ? 0 : total_sectors;
+    uint16_t root_entries = fat32 ? 0 : FAT_ROOT_ENTRIES;
+    uint16_t small_fat_size = fat32 ? 0 : fat_size;
+    const char* fs_type = fat32                                        ? "FAT32   " :
+                          layout->fat_type == VIRTUAL_FAT_TYPE_FAT16 ? "FAT16   " :
+                                                                       "FAT12   ";
+
     memset(buffer, 0, SECTOR_SIZE);
 
     /* clang-format off */
 
     // Jump instruction (3 bytes)
     buffer[0] = 0xEB;
-    buffer[1] = 0x58;
+    buffer[1] = code_offset - 2;
     buffer[2] = 0x90;
 
     // OEM Name (8 bytes)
@@ -434,17 +791,17 @@ static void generate_boot_sector(uint8_t* buffer, uint32_t total_sectors) {
     // BIOS Parameter Block (BPB)
     buffer[11] = SECTOR_SIZE & 0xFF;           // Bytes per sector (LSB)
     buffer[12] = (SECTOR_SIZE >> 8) & 0xFF;    // Bytes per sector (MSB)
-    buffer[13] = SECTORS_PER_CLUSTER;          // Sectors per cluster
-    buffer[14] = RESERVED_SECTORS & 0xFF;      // Reserved sectors (LSB)
-    buffer[15] = (RESERVED_SECTORS >> 8) & 0xFF; // Reserved sectors (MSB)
+    buffer[13] = layout->sectors_per_cluster;  // Sectors per cluster
+    buffer[14] = layout->reserved_sectors & 0xFF; // Reserved sectors (LSB)
+    buffer[15] = (layout->reserved_sectors >> 8) & 0xFF; // Reserved sectors (MSB)
     buffer[16] = FAT_COPIES;                   // Number of FATs
-    buffer[17] = 0;                            // Root entries (0 for FAT32)
-    buffer[18] = 0;
-    buffer[19] = 0;                            // Small sectors (0 for FAT32)
-    buffer[20] = 0;
+    buffer[17] = root_entries & 0xFF;          // Root entries (0 for FAT32)
+    buffer[18] = (root_entries >> 8) & 0xFF;
+    buffer[19] = small_sectors & 0xFF;         // Small sectors (0 for FAT32)
+    buffer[20] = (small_sectors >> 8) & 0xFF;
     buffer[21] = 0xF8;                         // Media descriptor (removable disk)
-    buffer[22] = 0;                            // FAT size (0 for FAT32)
-    buffer[23] = 0;
+    buffer[22] = small_fat_size & 0xFF;        // FAT size (0 for FAT32)
+    buffer[23] = (small_fat_size >> 8) & 0xFF;
     buffer[24] = 0x3F;                         // Sectors per track (63)
     buffer[25] = 0x00;
     buffer[26] = 0xFF;                         // Number of heads (255)
@@ -455,54 +812,52 @@ static void generate_boot_sector(uint8_t* buffer, uint32_t total_sectors) {
     buffer[31] = 0x00;
 
     // Total sectors (4 bytes)
-    buffer[32] = total_sectors & 0xFF;
-    buffer[33] = (total_sectors >> 8) & 0xFF;
-    buffer[34] = (total_sectors >> 16) & 0xFF;
-    buffer[35] = (total_sectors >> 24) & 0xFF;
-
-    // Calculate FAT size
-    uint32_t cluster_count = total_sectors / SECTORS_PER_CLUSTER;
-    uint32_t fat_size = ((cluster_count * 4) + SECTOR_SIZE - 1) / SECTOR_SIZE;
-
-    // FAT32 Extended BPB
-    buffer[36] = fat_size & 0xFF;              // FAT size (4 bytes)
-    buffer[37] = (fat_size >> 8) & 0xFF;
-    buffer[38] = (fat_size >> 16) & 0xFF;
-    buffer[39] = (fat_size >> 24) & 0xFF;
-    buffer[40] = 0x00;                         // Extended flags
-    buffer[41] = 0x00;
-    buffer[42] = 0x00;                         // File system version
-    buffer[43] = 0x00;
-    buffer[44] = 0x02;                         // Root cluster (cluster 2)
-    buffer[45] = 0x00;
-    buffer[46] = 0x00;
-    buffer[47] = 0x00;
-    buffer[48] = 0x01;                         // FS Info sector (sector 1)
-    buffer[49] = 0x00;
-    buffer[50] = 0x06;                         // Backup boot sector (sector 6)
-    buffer[51] = 0x00;
-    // Bytes 52-63: Reserved (already zeroed)
-
-    // Extended boot signature fields
-    buffer[64] = 0x80;                         // Drive number (0x80 = hard disk)
-    buffer[65] = 0x00;                         // Reserved
-    buffer[66] = 0x29;                         // Extended boot signature
-    buffer[67] = 0x12;                         // Volume serial (4 bytes)
-    buffer[68] = 0x34;
-    buffer[69] = 0x56;
-    buffer[70] = 0x78;
-    memcpy(&buffer[71], "Boot2Flippr", 11);   // Volume label (11 bytes)
-    memcpy(&buffer[82], "FAT32   ", 8);       // File system type (8 bytes)
-
-    // FAT32 Bootstrap code - loads BOOT.CFG via iPXE embedded script
+    buffer[32] = large_sectors & 0xFF;
+    buffer[33] = (large_sectors >> 8) & 0xFF;
+    buffer[34] = (large_sectors >> 16) & 0xFF;
+    buffer[35] = (large_sectors >> 24) & 0xFF;
+
+    if(fat32) {
+        // FAT32 Extended BPB
+        buffer[36] = fat_size & 0xFF;          // FAT size (4 bytes)
+        buffer[37] = (fat_size >> 8) & 0xFF;
+        buffer[38] = (fat_size >> 16) & 0xFF;
+        buffer[39] = (fat_size >> 24) & 0xFF;
+        buffer[40] = 0x00;                     // Extended flags
+        buffer[41] = 0x00;
+        buffer[42] = 0x00;                     // File system version
+        buffer[43] = 0x00;
+        buffer[44] = 0x02;                     // Root cluster (cluster 2)
+        buffer[45] = 0x00;
+        buffer[46] = 0x00;
+        buffer[47] = 0x00;
+        buffer[48] = 0x01;                     // FS Info sector (sector 1)
+        buffer[49] = 0x00;
+        buffer[50] = 0x06;                     // Backup boot sector (sector 6)
+        buffer[51] = 0x00;
+        // Bytes 52-63: Reserved (already zeroed)
+    }
+
+    // Extended boot signature fields (offset 64 on FAT32, 36 on FAT12/FAT16)
+    ebpb[0] = 0x80;                            // Drive number (0x80 = hard disk)
+    ebpb[1] = 0x00;                            // Reserved
+    ebpb[2] = 0x29;                            // Extended boot signature
+    ebpb[3] = 0x12;                            // Volume serial (4 bytes)
+    ebpb[4] = 0x34;
+    ebpb[5] = 0x56;
+    ebpb[6] = 0x78;
+    memcpy(&ebpb[7], "Boot2Flippr", 11);      // Volume label (11 bytes)
+    memcpy(&ebpb[18], fs_type, 8);            // File system type (8 bytes)
+
+    // Bootstrap code - loads BOOT.CFG via iPXE embedded script
     // NOTE: For actual BIOS boot, you need to:
     // 1. Build iPXE with embedded script pointing to BOOT.CFG
     // 2. Replace this boot sector with the iPXE boot sector
     // 3. Keep the BPB (bytes 0-89) from this sector
     //
     // For now, this is a placeholder that prints a message
-    const uint8_t fat32_bootstrap[] = {
-        // Code starts at offset 90 (after BPB)
+    const uint8_t bootstrap[] = {
+        // Code starts at code_offset (after BPB)
         0xFA,                           // CLI
         0x33, 0xC0,                     // XOR AX, AX
         0x8E, 0xD0,                     // MOV SS, AX
@@ -526,7 +881,7 @@ static void generate_boot_sector(uint8_t* buffer, uint32_t total_sectors) {
 
     /* clang-format on */
 
-    memcpy(&buffer[90], fat32_bootstrap, sizeof(fat32_bootstrap));
+    memcpy(&buffer[code_offset], bootstrap, sizeof(bootstrap));
 
     // Message at offset 256
     const char* message = "Use UEFI boot (BOOTX64.EFI) or embed iPXE in boot sector\r\n\0";
@@ -571,58 +926,14 @@ static void generate_fsinfo_sector(uint8_t* buffer) {
     buffer[511] = 0xAA;
 }
 
-static void generate_fat_sector(VirtualFat* vfat, uint32_t fat_sector, uint8_t* buffer) {
-    memset(buffer, 0, SECTOR_SIZE);
-
-    uint32_t* fat = (uint32_t*)buffer;
-    uint32_t entries_per_sector = SECTOR_SIZE / 4;
-    uint32_t first_entry = fat_sector * entries_per_sector;
-
-    // First FAT sector has special entries
-    if(fat_sector == 0) {
-        fat[0] = 0x0FFFFFF8; // Media descriptor
-        fat[1] = 0x0FFFFFFF; // End of chain marker
-        fat[2] = 0x0FFFFFFF; // Root directory (cluster 2) - end of chain
+// Calculate LFN checksum for 8.3 name
+static uint8_t lfn_checksum(const char* short_name) {
+    uint8_t sum = 0;
+    for(int i = 0; i < 11; i++) {
+        sum = ((sum & 1) << 7) + (sum >> 1) + (uint8_t)short_name[i];
     }
-
-    // Build FAT chain for each file and directory
-    for(uint8_t i = 0; i < vfat->file_count; i++) {
-        VirtualFatFile* file = &vfat->files[i];
-
-        uint32_t clusters;
-        if(file->is_directory) {
-            // Directories always have at least 1 cluster
-            clusters = 1;
-        } else {
-            // Files: calculate based on size
-            clusters = (file->size + (SECTORS_PER_CLUSTER * SECTOR_SIZE) - 1) /
-                       (SECTORS_PER_CLUSTER * SECTOR_SIZE);
-        }
-
-        for(uint32_t c = 0; c < clusters; c++) {
-            uint32_t cluster_num = file->start_cluster + c;
-
-            if(cluster_num >= first_entry && cluster_num < first_entry + entries_per_sector) {
-                uint32_t idx = cluster_num - first_entry;
-
-                if(c == clusters - 1) {
-                    fat[idx] = 0x0FFFFFFF; // End of chain
-                } else {
-                    fat[idx] = cluster_num + 1; // Next cluster
-                }
-            }
-        }
-    }
-}
-
-// Calculate LFN checksum for 8.3 name
-static uint8_t lfn_checksum(const char* short_name) {
-    uint8_t sum = 0;
-    for(int i = 0; i < 11; i++) {
-        sum = ((sum & 1) << 7) + (sum >> 1) + (uint8_t)short_name[i];
-    }
-    return sum;
-}
+    return sum;
+}
 
 // Generate one LFN entry (each holds 13 UTF-16 characters)
 static void
@@ -717,127 +1028,948 @@ static void write_directory_entry(
     entry[31] = (size >> 24) & 0xFF;
 }
 
-static void generate_root_directory(VirtualFat* vfat, uint8_t* buffer) {
+// Directory entries taken by a file: LFN entries (13 chars each) plus 8.3 entry
+static uint16_t entry_count(VirtualFat* vfat, uint16_t index) {
+    const char* long_name = pool_str(vfat, vfat->files[index].long_name);
+    return (strlen(long_name) + 12) / 13 + 1;
+}
+
+// Group children by parent and number their directory entry slots
+static void build_directory_index(VirtualFat* vfat) {
+    if(vfat->children != NULL) return;
+
+    vfat->children = malloc(sizeof(uint16_t) * (vfat->file_count + 1));
+    vfat->child_slot = malloc(sizeof(uint32_t) * (vfat->file_count + 1));
+    vfat->child_start = malloc(sizeof(uint16_t) * (vfat->file_count + 3));
+    memset(vfat->child_start, 0, sizeof(uint16_t) * (vfat->file_count + 3));
+
+    // Counting sort on parent_index, stable so listings keep registration order
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        vfat->child_start[vfat->files[i].parent_index + 3]++;
+    }
+    for(uint16_t g = 1; g < vfat->file_count + 3; g++) {
+        vfat->child_start[g] += vfat->child_start[g - 1];
+    }
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        vfat->children[vfat->child_start[vfat->files[i].parent_index + 2]++] = i;
+    }
+
+    // Subdirectories start with the . and .. entries
+    for(int16_t dir = -1; dir < (int16_t)vfat->file_count; dir++) {
+        uint32_t slot = dir < 0 ? 0 : 2;
+        for(uint16_t pos = vfat->child_start[dir + 1]; pos < vfat->child_start[dir + 2]; pos++) {
+            vfat->child_slot[pos] = slot;
+            slot += entry_count(vfat, vfat->children[pos]);
+        }
+    }
+}
+
+// Number of directory entries in a directory (-1 for root)
+static uint32_t directory_entries(VirtualFat* vfat, int16_t dir_index) {
+    uint16_t first = vfat->child_start[dir_index + 1];
+    uint16_t end = vfat->child_start[dir_index + 2];
+
+    if(first == end) return dir_index < 0 ? 0 : 2;
+    return vfat->child_slot[end - 1] + entry_count(vfat, vfat->children[end - 1]);
+}
+
+// Clusters taken by a directory, at least one even when empty
+static uint32_t directory_clusters(VirtualFat* vfat, int16_t dir_index, uint32_t cluster_bytes) {
+    uint32_t bytes = directory_entries(vfat, dir_index) * 32;
+    return bytes == 0 ? 1 : (bytes + cluster_bytes - 1) / cluster_bytes;
+}
+
+// Write the entries of one child that fall into the sector starting at slot window
+static void write_child_entries(
+    VirtualFat* vfat,
+    uint16_t index,
+    uint32_t slot,
+    uint32_t window,
+    uint8_t* buffer) {
+    VirtualFatFile* file = &vfat->files[index];
+    const char* long_name = pool_str(vfat, file->long_name);
+    uint8_t lfn_entries = entry_count(vfat, index) - 1;
+    uint8_t checksum = lfn_checksum(file->name);
+
+    // LFN entries in reverse order, then the 8.3 entry
+    for(uint16_t j = 0; j <= lfn_entries; j++, slot++) {
+        if(slot < window || slot >= window + DIR_ENTRIES_PER_SECTOR) continue;
+
+        uint8_t* entry = buffer + (slot - window) * 32;
+        if(j < lfn_entries) {
+            uint8_t seq = lfn_entries - j;
+            if(j == 0) seq |= LFN_LAST; // Mark last entry
+            write_lfn_entry(entry, seq, long_name, checksum);
+        } else {
+            uint8_t attributes = file->is_directory ? 0x10 : 0x20;
+            write_directory_entry(entry, file->name, attributes, file->start_cluster, file->size);
+        }
+    }
+}
+
+// Generate one sector of a directory listing (-1 for root)
+// Subdirectories include . and .. entries
+static void generate_directory_sector(
+    VirtualFat* vfat,
+    int16_t dir_index,
+    uint32_t sector,
+    uint8_t* buffer) {
     memset(buffer, 0, SECTOR_SIZE);
 
-    uint8_t* entry = buffer;
-    uint8_t entry_count = 0;
+    uint32_t window = sector * DIR_ENTRIES_PER_SECTOR;
 
-    FURI_LOG_I(TAG, "Generating root directory, file_count: %u", vfat->file_count);
+    if(dir_index >= 0 && sector == 0) {
+        VirtualFatFile* dir = &vfat->files[dir_index];
 
-    // Only show files/dirs with parent_index == -1 (root)
-    for(uint8_t i = 0; i < vfat->file_count && entry_count < (SECTOR_SIZE / 32); i++) {
-        VirtualFatFile* file = &vfat->files[i];
+        // . entry (self)
+        char dot_name[11];
+        memset(dot_name, ' ', 11);
+        dot_name[0] = '.';
+        write_directory_entry(buffer, dot_name, 0x10, dir->start_cluster, 0);
 
-        if(file->parent_index != -1) {
-            FURI_LOG_D(
-                TAG, "Skipping file %u (not in root, parent_index=%d)", i, file->parent_index);
-            continue; // Skip non-root entries
+        // .. entry (parent)
+        char dotdot_name[11];
+        memset(dotdot_name, ' ', 11);
+        dotdot_name[0] = '.';
+        dotdot_name[1] = '.';
+
+        uint32_t parent_cluster = vfat->layout.root_cluster; // Default to root
+        if(dir->parent_index >= 0) {
+            parent_cluster = vfat->files[dir->parent_index].start_cluster;
         }
+        write_directory_entry(buffer + 32, dotdot_name, 0x10, parent_cluster, 0);
+    }
 
-        // Write LFN entries if long name exists
-        if(file->long_name[0] != '\0') {
-            uint8_t lfn_len = strlen(file->long_name);
-            uint8_t lfn_entries = (lfn_len + 12) / 13; // Each LFN entry holds 13 chars
-            uint8_t checksum = lfn_checksum(file->name);
-
-            // Write LFN entries in reverse order
-            for(int8_t j = lfn_entries; j >= 1 && entry_count < (SECTOR_SIZE / 32); j--) {
-                uint8_t seq = j;
-                if(j == lfn_entries) seq |= LFN_LAST; // Mark last entry
-                write_lfn_entry(entry, seq, file->long_name, checksum);
-                entry += 32;
-                entry_count++;
-            }
+    // Binary search for the last child starting at or before the window
+    uint16_t first = vfat->child_start[dir_index + 1];
+    uint16_t end = vfat->child_start[dir_index + 2];
+    uint16_t low = first;
+    uint16_t high = end;
+    while(low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if(vfat->child_slot[mid] <= window) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // Child entries, the first one may start in the previous sector
+    for(uint16_t pos = low > first ? low - 1 : first;
+        pos < end && vfat->child_slot[pos] < window + DIR_ENTRIES_PER_SECTOR;
+        pos++) {
+        write_child_entries(vfat, vfat->children[pos], vfat->child_slot[pos], window, buffer);
+    }
+
+    FURI_LOG_D(TAG, "Directory %d sector %lu generated", dir_index, sector);
+}
+
+// Get an open handle for an SD-backed file
+// Handles are opened on first use and kept until virtual_fat_free, the least
+// recently used one is closed when all slots are taken
+static VirtualFatHandle* acquire_sd_handle(Storage* storage, VirtualFat* vfat, uint16_t index) {
+    VirtualFatHandle* victim = &vfat->handles[0];
+    vfat->handle_clock++;
+
+    for(uint8_t i = 0; i < SD_HANDLE_SLOTS; i++) {
+        VirtualFatHandle* handle = &vfat->handles[i];
+        if(handle->file_index == (int16_t)index) {
+            handle->last_used = vfat->handle_clock;
+            return handle;
         }
+        // Prefer a free slot, otherwise the oldest one
+        if(victim->file_index >= 0 &&
+           (handle->file_index < 0 || handle->last_used < victim->last_used)) {
+            victim = handle;
+        }
+    }
+
+    if(victim->file == NULL) {
+        victim->file = storage_file_alloc(storage);
+    } else if(victim->file_index >= 0) {
+        storage_file_close(victim->file);
+    }
+    victim->file_index = -1;
+
+    const char* sd_path = pool_str(vfat, vfat->files[index].sd_path);
+    vfat->stats.sd_opens++;
 
-        // Write 8.3 directory entry
-        uint8_t attributes = file->is_directory ? 0x10 : 0x20;
-        write_directory_entry(entry, file->name, attributes, file->start_cluster, file->size);
+    if(!storage_file_open(victim->file, sd_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        FURI_LOG_E(TAG, "Failed to open SD file: %s", sd_path);
+        return NULL;
+    }
 
-        FURI_LOG_I(
+    victim->file_index = index;
+    victim->position = 0;
+    victim->last_used = vfat->handle_clock;
+
+    return victim;
+}
+
+// Read from SD-backed file through the handle cache
+static bool read_sd_file(
+    Storage* storage,
+    VirtualFat* vfat,
+    uint16_t index,
+    uint32_t offset,
+    uint8_t* buffer,
+    uint32_t size) {
+    VirtualFatHandle* handle = acquire_sd_handle(storage, vfat, index);
+    if(handle == NULL) return false;
+
+    // Sequential reads continue where the previous one stopped
+    if(handle->position != offset) {
+        vfat->stats.sd_seeks++;
+        if(!storage_file_seek(handle->file, offset, true)) {
+            FURI_LOG_E(TAG, "SD seek failed: offset %lu", offset);
+            // Position is unknown now, force a seek next time
+            handle->position = UINT32_MAX;
+            return false;
+        }
+        handle->position = offset;
+    }
+
+    vfat->stats.sd_reads++;
+    size_t bytes_read = storage_file_read(handle->file, buffer, size);
+    handle->position += bytes_read;
+
+    if(bytes_read != size) {
+        // The file shrank since registration, the rest of the buffer is stale
+        FURI_LOG_E(TAG, "SD read short: expected %lu, got %u", size, (unsigned int)bytes_read);
+        return false;
+    }
+
+    return true;
+}
+
+// Load the offset index of a packed file into the packed cache
+static bool load_packed_index(Storage* storage, VirtualFat* vfat, uint16_t index) {
+    VirtualFatPackedCache* packed = &vfat->packed;
+    packed->file_index = -1;
+    packed->block = -1;
+
+    uint8_t header_data[PACKED_FILE_HEADER_SIZE];
+    memset(header_data, 0, sizeof(header_data));
+    if(!read_sd_file(storage, vfat, index, 0, header_data, PACKED_FILE_HEADER_SIZE) ||
+       !packed_file_parse_header(header_data, &packed->header) ||
+       packed->header.size != vfat->files[index].size ||
+       packed->header.block_size > packed->buffer_size) {
+        // Block buffers are sized from the headers seen at registration
+        FURI_LOG_E(TAG, "Packed file header changed: %.11s", vfat->files[index].name);
+        return false;
+    }
+
+    uint32_t index_size = (packed->header.block_count + 1) * sizeof(uint32_t);
+    free(packed->offsets);
+    packed->offsets = malloc(index_size);
+    memset(packed->offsets, 0, index_size);
+    if(!read_sd_file(
+           storage,
+           vfat,
+           index,
+           PACKED_FILE_HEADER_SIZE,
+           (uint8_t*)packed->offsets,
+           index_size)) {
+        return false;
+    }
+
+    // A file truncated since registration would fail block reads part way through
+    VirtualFatHandle* handle = acquire_sd_handle(storage, vfat, index);
+    if(handle == NULL ||
+       storage_file_size(handle->file) < packed->offsets[packed->header.block_count]) {
+        FURI_LOG_E(TAG, "Packed file truncated: %.11s", vfat->files[index].name);
+        return false;
+    }
+
+    if(packed->data == NULL) {
+        packed->data = malloc(packed->buffer_size);
+        packed->input = malloc(packed->buffer_size);
+    }
+
+    packed->file_index = index;
+    return true;
+}
+
+// Decode one block of the packed file whose index is loaded
+static bool decode_packed_block(Storage* storage, VirtualFat* vfat, uint32_t block) {
+    VirtualFatPackedCache* packed = &vfat->packed;
+    if(packed->block == (int32_t)block) return true;
+
+    uint16_t index = packed->file_index;
+    uint32_t block_size = packed->header.block_size;
+    uint32_t block_len = packed->header.size - block * block_size;
+    if(block_len > block_size) block_len = block_size;
+
+    uint32_t start = packed->offsets[block];
+    uint32_t end = packed->offsets[block + 1];
+    if(end < start || end - start > block_len) {
+        FURI_LOG_E(TAG, "Corrupt packed index: %.11s block %lu", vfat->files[index].name, block);
+        return false;
+    }
+
+    // Only a block that was read and decoded whole is cached
+    packed->block = -1;
+    vfat->stats.packed_blocks++;
+
+    if(end - start == block_len) {
+        // Incompressible block, stored as is
+        if(!read_sd_file(storage, vfat, index, start, packed->data, block_len)) return false;
+    } else {
+        if(!read_sd_file(storage, vfat, index, start, packed->input, end - start)) return false;
+        if(!packed_file_decompress(packed->input, end - start, packed->data, block_len)) {
+            FURI_LOG_E(
+                TAG, "Corrupt packed block: %.11s block %lu", vfat->files[index].name, block);
+            return false;
+        }
+    }
+
+    packed->block = block;
+    return true;
+}
+
+// Read from a packed SD file, only the blocks covering the range are decoded
+static bool read_packed_file(
+    Storage* storage,
+    VirtualFat* vfat,
+    uint16_t index,
+    uint32_t offset,
+    uint8_t* buffer,
+    uint32_t size) {
+    VirtualFatPackedCache* packed = &vfat->packed;
+    if(packed->file_index != (int16_t)index && !load_packed_index(storage, vfat, index)) {
+        return false;
+    }
+
+    uint32_t block_size = packed->header.block_size;
+
+    while(size > 0) {
+        uint32_t block = offset / block_size;
+        uint32_t block_offset = offset % block_size;
+        if(!decode_packed_block(storage, vfat, block)) return false;
+
+        uint32_t chunk = block_size - block_offset;
+        if(chunk > size) chunk = size;
+        memcpy(buffer, packed->data + block_offset, chunk);
+
+        buffer += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+// FAT size in sectors for a given number of data clusters
+static uint32_t fat_sectors(VirtualFatType fat_type, uint32_t clusters) {
+    uint32_t entries = clusters + 2;
+    uint32_t bytes;
+    if(fat_type == VIRTUAL_FAT_TYPE_FAT12) {
+        bytes = (entries * 3 + 1) / 2;
+    } else if(fat_type == VIRTUAL_FAT_TYPE_FAT16) {
+        bytes = entries * 2;
+    } else {
+        bytes = entries * 4;
+    }
+    return (bytes + SECTOR_SIZE - 1) / SECTOR_SIZE;
+}
+
+static void compute_layout(
+    VirtualFatLayout* layout,
+    uint32_t partition_sectors,
+    VirtualFatType fat_type,
+    uint8_t sectors_per_cluster) {
+    layout->fat_type = fat_type;
+    layout->sectors_per_cluster = sectors_per_cluster;
+    layout->partition_sectors = partition_sectors;
+
+    if(fat_type == VIRTUAL_FAT_TYPE_FAT32) {
+        layout->reserved_sectors = RESERVED_SECTORS;
+        layout->root_dir_sectors = 0;
+        layout->root_cluster = 2;
+    } else {
+        layout->reserved_sectors = 1;
+        layout->root_dir_sectors = FAT_ROOT_ENTRIES * 32 / SECTOR_SIZE;
+        layout->root_cluster = 0;
+    }
+
+    // Size the FAT for every cluster the area after the reserved sectors and
+    // root directory could hold, then count the clusters that remain once
+    // both FAT copies are placed
+    uint32_t available = partition_sectors - layout->reserved_sectors - layout->root_dir_sectors;
+    layout->fat_size = fat_sectors(fat_type, available / sectors_per_cluster);
+    layout->cluster_count = (available - FAT_COPIES * layout->fat_size) / sectors_per_cluster;
+
+    layout->fat1_start = PARTITION_START + layout->reserved_sectors;
+    layout->fat2_start = layout->fat1_start + layout->fat_size;
+    layout->root_start = layout->fat2_start + layout->fat_size;
+    layout->data_start = layout->root_start + layout->root_dir_sectors;
+}
+
+// Find the largest cluster size up to max_sectors_per_cluster whose cluster
+// count matches the FAT type (fewer clusters means fewer FAT sectors to read)
+static bool fit_layout(
+    VirtualFatLayout* layout,
+    uint32_t partition_sectors,
+    VirtualFatType fat_type,
+    uint8_t max_sectors_per_cluster) {
+    uint32_t min_clusters = 1;
+    uint32_t max_clusters = FAT12_MAX_CLUSTERS;
+    if(fat_type == VIRTUAL_FAT_TYPE_FAT16) {
+        min_clusters = FAT16_MIN_CLUSTERS;
+        max_clusters = FAT16_MAX_CLUSTERS;
+    } else if(fat_type == VIRTUAL_FAT_TYPE_FAT32) {
+        min_clusters = FAT32_MIN_CLUSTERS;
+        max_clusters = 0x0FFFFFF5;
+    }
+
+    for(uint8_t spc = max_sectors_per_cluster; spc >= 1; spc /= 2) {
+        compute_layout(layout, partition_sectors, fat_type, spc);
+        if(layout->cluster_count > max_clusters) return false; // Only grows from here
+        if(layout->cluster_count >= min_clusters) return true;
+    }
+
+    return false;
+}
+
+static const char* fat_type_name(VirtualFatType fat_type) {
+    switch(fat_type) {
+    case VIRTUAL_FAT_TYPE_FAT12:
+        return "FAT12";
+    case VIRTUAL_FAT_TYPE_FAT16:
+        return "FAT16";
+    default:
+        return "FAT32";
+    }
+}
+
+// Pick FAT type and cluster size: the requested ones when the volume allows
+// them, otherwise the closest valid combination
+static void resolve_layout(VirtualFat* vfat, uint32_t total_sectors) {
+    // Partition size depends on scheme (use macros from virtual_fat.h)
+    uint32_t partition_sectors = (vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) ?
+                                     PARTITION_SECTORS_GPT(total_sectors) :
+                                     PARTITION_SECTORS_MBR(total_sectors);
+
+    uint8_t max_spc = vfat->sectors_per_cluster;
+    if(max_spc == SECTORS_PER_CLUSTER_AUTO) {
+        max_spc = SECTORS_PER_CLUSTER_MAX;
+    }
+
+    // UEFI sessions keep FAT32, BIOS-only sessions use the smallest FAT that fits
+    VirtualFatType fat_type = vfat->fat_type;
+    if(fat_type == VIRTUAL_FAT_TYPE_AUTO) {
+        if(vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) {
+            fat_type = VIRTUAL_FAT_TYPE_FAT32;
+        } else if(partition_sectors < FAT12_MAX_VOLUME_SECTORS) {
+            fat_type = VIRTUAL_FAT_TYPE_FAT12;
+        } else {
+            fat_type = VIRTUAL_FAT_TYPE_FAT16;
+        }
+    }
+
+    if(!fit_layout(&vfat->layout, partition_sectors, fat_type, max_spc)) {
+        // Volume too small for FAT32 or too large for FAT12/FAT16 at this cluster size
+        const VirtualFatType fallback[] = {
+            VIRTUAL_FAT_TYPE_FAT32,
+            VIRTUAL_FAT_TYPE_FAT16,
+            VIRTUAL_FAT_TYPE_FAT12,
+        };
+        for(size_t i = 0; i < COUNT_OF(fallback); i++) {
+            if(fit_layout(&vfat->layout, partition_sectors, fallback[i], max_spc)) break;
+        }
+
+        FURI_LOG_W(
             TAG,
-            "Root entry %u: %.11s (LFN: %s), cluster: %lu, size: %lu, dir: %d",
-            entry_count,
-            file->name,
-            file->long_name[0] ? file->long_name : "none",
-            file->start_cluster,
-            file->size,
-            file->is_directory);
+            "%s not possible for this volume, using %s",
+            fat_type_name(fat_type),
+            fat_type_name(vfat->layout.fat_type));
+    }
 
-        entry += 32;
-        entry_count++;
+    if(vfat->sectors_per_cluster != SECTORS_PER_CLUSTER_AUTO &&
+       vfat->sectors_per_cluster != vfat->layout.sectors_per_cluster) {
+        FURI_LOG_W(
+            TAG,
+            "Cluster size %u too large for %s, using %u",
+            vfat->sectors_per_cluster,
+            fat_type_name(vfat->layout.fat_type),
+            vfat->layout.sectors_per_cluster);
     }
 
-    FURI_LOG_I(TAG, "Root directory complete, total entries: %u", entry_count);
+    vfat->layout.total_sectors = total_sectors;
+
+    FURI_LOG_I(
+        TAG,
+        "Layout: %lu sectors, %s, %u sectors/cluster, %lu clusters, FAT size %lu",
+        total_sectors,
+        fat_type_name(vfat->layout.fat_type),
+        vfat->layout.sectors_per_cluster,
+        vfat->layout.cluster_count,
+        vfat->layout.fat_size);
 }
 
-// Generate subdirectory content (includes . and .. entries)
-static void generate_subdirectory(VirtualFat* vfat, int8_t dir_index, uint8_t* buffer) {
-    memset(buffer, 0, SECTOR_SIZE);
+// Binary search the metadata index, copy the cached sector on hit
+static bool metadata_cache_read(VirtualFat* vfat, uint32_t lba, uint8_t* buffer) {
+    uint16_t lo = 0;
+    uint16_t hi = vfat->metadata_count;
 
-    if(dir_index < 0 || dir_index >= vfat->file_count) return;
+    while(lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        const VirtualFatMetadataEntry* entry = &vfat->metadata_index[mid];
+        if(entry->lba == lba) {
+            memcpy(buffer, vfat->metadata_sectors + entry->slot * SECTOR_SIZE, SECTOR_SIZE);
+            return true;
+        }
+        if(entry->lba < lba) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
 
-    VirtualFatFile* dir = &vfat->files[dir_index];
-    if(!dir->is_directory) return;
+    return false;
+}
 
-    uint8_t* entry = buffer;
+// Render MBR, boot/FSInfo sectors (and FAT32 backups) and directory sectors once
+// Identical sectors (boot sector and its backup) share one pool slot. Sectors
+// that do not fit under metadata_cache_limit are left to on-demand rendering.
+static void build_metadata_cache(VirtualFat* vfat) {
+    uint32_t max_slots = vfat->metadata_cache_limit / SECTOR_SIZE;
+    if(max_slots == 0) return;
+
+    const VirtualFatLayout* layout = &vfat->layout;
+
+    // Fixed metadata sectors first, then the first sector of every directory
+    uint16_t max_entries = 6 + vfat->file_count;
+    uint32_t* lbas = malloc(sizeof(uint32_t) * max_entries);
+    uint16_t lba_count = 0;
+
+    lbas[lba_count++] = 0;
+    lbas[lba_count++] = PARTITION_START;
+    if(layout->fat_type == VIRTUAL_FAT_TYPE_FAT32) {
+        lbas[lba_count++] = PARTITION_START + 1;
+        lbas[lba_count++] = PARTITION_START + 6;
+        lbas[lba_count++] = PARTITION_START + 7;
+        lbas[lba_count++] = layout->data_start;
+    } else {
+        lbas[lba_count++] = layout->root_start;
+    }
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        if(vfat->files[i].is_directory) {
+            lbas[lba_count++] = layout->data_start +
+                                (vfat->files[i].start_cluster - 2) * layout->sectors_per_cluster;
+        }
+    }
+
+    if(max_slots > lba_count) max_slots = lba_count;
 
-    // . entry (self)
-    char dot_name[11];
-    memset(dot_name, ' ', 11);
-    dot_name[0] = '.';
-    write_directory_entry(entry, dot_name, 0x10, dir->start_cluster, 0);
-    entry += 32;
+    vfat->metadata_index = malloc(sizeof(VirtualFatMetadataEntry) * lba_count);
+    vfat->metadata_sectors = malloc(max_slots * SECTOR_SIZE);
+    vfat->metadata_count = 0;
 
-    // .. entry (parent)
-    char dotdot_name[11];
-    memset(dotdot_name, ' ', 11);
-    dotdot_name[0] = '.';
-    dotdot_name[1] = '.';
+    uint8_t* sector = malloc(SECTOR_SIZE);
+    uint16_t slot_count = 0;
+    uint16_t skipped = 0;
 
-    uint32_t parent_cluster = 2; // Default to root
-    if(dir->parent_index >= 0) {
-        parent_cluster = vfat->files[dir->parent_index].start_cluster;
+    for(uint16_t i = 0; i < lba_count; i++) {
+        // Cache misses while building, so this runs the regular generators
+        if(!virtual_fat_read_sector(NULL, vfat, lbas[i], sector)) continue;
+
+        uint16_t slot = 0;
+        while(slot < slot_count &&
+              memcmp(vfat->metadata_sectors + slot * SECTOR_SIZE, sector, SECTOR_SIZE) != 0) {
+            slot++;
+        }
+
+        if(slot == slot_count) {
+            if(slot_count >= max_slots) {
+                skipped++;
+                continue;
+            }
+            memcpy(vfat->metadata_sectors + slot * SECTOR_SIZE, sector, SECTOR_SIZE);
+            slot_count++;
+        }
+
+        // Keep the index sorted by LBA
+        uint16_t pos = vfat->metadata_count;
+        while(pos > 0 && vfat->metadata_index[pos - 1].lba > lbas[i]) {
+            vfat->metadata_index[pos] = vfat->metadata_index[pos - 1];
+            pos--;
+        }
+        vfat->metadata_index[pos].lba = lbas[i];
+        vfat->metadata_index[pos].slot = slot;
+        vfat->metadata_count++;
     }
-    write_directory_entry(entry, dotdot_name, 0x10, parent_cluster, 0);
-    entry += 32;
 
-    // Child entries
-    uint8_t entry_count = 2; // Already have . and ..
-    for(uint8_t i = 0; i < vfat->file_count && entry_count < (SECTOR_SIZE / 32); i++) {
+    free(sector);
+    free(lbas);
+
+    FURI_LOG_I(
+        TAG,
+        "Metadata cache: %u sectors in %u slots, %u rendered on demand",
+        vfat->metadata_count,
+        slot_count,
+        skipped);
+}
+
+// Clusters needed by all entries with the resolved cluster size
+static uint32_t count_clusters(VirtualFat* vfat) {
+    uint32_t cluster_bytes = vfat->layout.sectors_per_cluster * SECTOR_SIZE;
+
+    // FAT32 keeps the root directory in the data area, starting at cluster 2
+    uint32_t clusters =
+        vfat->layout.root_cluster != 0 ? directory_clusters(vfat, -1, cluster_bytes) : 0;
+
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
         VirtualFatFile* file = &vfat->files[i];
+        clusters += file->is_directory ? directory_clusters(vfat, i, cluster_bytes) :
+                                         (file->size + cluster_bytes - 1) / cluster_bytes;
+    }
+
+    return clusters;
+}
+
+bool virtual_fat_seal(VirtualFat* vfat) {
+    if(vfat == NULL) return false;
+    if(vfat->sealed) return true;
+
+    uint32_t total_sectors = vfat->min_total_sectors;
+    if(total_sectors == 0) {
+        total_sectors = (vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) ?
+                            MIN_TOTAL_SECTORS_GPT :
+                            MIN_TOTAL_SECTORS_MBR;
+    }
+
+    build_directory_index(vfat);
+
+    // Grow the disk until everything fits. FAT type and cluster size depend on
+    // the disk size, so the layout is resolved again after each step.
+    for(uint8_t attempt = 0;; attempt++) {
+        resolve_layout(vfat, total_sectors);
+
+        uint32_t clusters_needed = count_clusters(vfat);
+        if(clusters_needed <= vfat->layout.cluster_count) break;
+
+        // Missing data sectors plus room for the larger FATs (at most 1/64 on FAT32)
+        uint64_t missing = (uint64_t)(clusters_needed - vfat->layout.cluster_count) *
+                           vfat->layout.sectors_per_cluster;
+        uint64_t grown = (uint64_t)total_sectors + missing + missing / 64 + DISK_SIZE_ALIGNMENT;
+        grown = (grown + DISK_SIZE_ALIGNMENT - 1) / DISK_SIZE_ALIGNMENT * DISK_SIZE_ALIGNMENT;
+
+        if(attempt == DISK_GROW_ATTEMPTS || grown > UINT32_MAX) {
+            FURI_LOG_E(
+                TAG,
+                "Files need %lu clusters, volume has %lu",
+                clusters_needed,
+                vfat->layout.cluster_count);
+            return false;
+        }
+
+        total_sectors = (uint32_t)grown;
+    }
+
+    // FAT12/FAT16 root directory has a fixed number of entries
+    uint32_t root_entries = directory_entries(vfat, -1);
+    if(vfat->layout.root_cluster == 0 && root_entries > FAT_ROOT_ENTRIES) {
+        FURI_LOG_E(
+            TAG,
+            "Root directory needs %lu entries, %s allows %u",
+            root_entries,
+            fat_type_name(vfat->layout.fat_type),
+            FAT_ROOT_ENTRIES);
+        return false;
+    }
+
+    uint32_t cluster_bytes = vfat->layout.sectors_per_cluster * SECTOR_SIZE;
+
+    vfat->extents = malloc(sizeof(VirtualFatExtent) * (vfat->file_count + 1));
+    vfat->extent_count = 0;
+    vfat->next_cluster = 2;
+
+    // FAT32: root directory comes first, files follow it
+    if(vfat->layout.root_cluster != 0) {
+        VirtualFatExtent* extent = &vfat->extents[vfat->extent_count++];
+        extent->start_cluster = vfat->layout.root_cluster;
+        extent->cluster_count = directory_clusters(vfat, -1, cluster_bytes);
+        extent->file_index = ROOT_INDEX;
+        vfat->next_cluster = extent->start_cluster + extent->cluster_count;
+    }
+
+    // Clusters are assigned in registration order, so extents come out sorted
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        VirtualFatFile* file = &vfat->files[i];
+
+        uint32_t clusters = file->is_directory ? directory_clusters(vfat, i, cluster_bytes) :
+                                                 (file->size + cluster_bytes - 1) / cluster_bytes;
+
+        // Empty files own no clusters
+        if(clusters == 0) {
+            file->start_cluster = 0;
+            continue;
+        }
+
+        file->start_cluster = vfat->next_cluster;
+        vfat->next_cluster += clusters;
+
+        VirtualFatExtent* extent = &vfat->extents[vfat->extent_count++];
+        extent->start_cluster = file->start_cluster;
+        extent->cluster_count = clusters;
+        extent->file_index = i;
+    }
+
+    vfat->last_extent = 0;
+    vfat->sealed = true;
+
+    FURI_LOG_I(TAG, "Sealed: %u entries, %u extents", vfat->file_count, vfat->extent_count);
+
+    build_gpt_cache(vfat);
+    build_metadata_cache(vfat);
+
+    return true;
+}
+
+static bool extent_contains(const VirtualFatExtent* extent, uint32_t cluster) {
+    return cluster >= extent->start_cluster &&
+           cluster - extent->start_cluster < extent->cluster_count;
+}
+
+// Find the extent owning a cluster, NULL for free clusters
+static const VirtualFatExtent* find_extent(VirtualFat* vfat, uint32_t cluster) {
+    if(vfat->extent_count == 0) return NULL;
+
+    // Sequential reads stay in the last extent or move on to the next one
+    uint16_t last = vfat->last_extent;
+    if(extent_contains(&vfat->extents[last], cluster)) {
+        return &vfat->extents[last];
+    }
+    if(last + 1 < vfat->extent_count && extent_contains(&vfat->extents[last + 1], cluster)) {
+        vfat->last_extent = last + 1;
+        return &vfat->extents[last + 1];
+    }
 
-        if(file->parent_index != dir_index) {
-            continue; // Not a child of this directory
+    // Binary search for the last extent starting at or before the cluster
+    uint16_t low = 0;
+    uint16_t high = vfat->extent_count;
+    while(low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if(vfat->extents[mid].start_cluster <= cluster) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
+    }
+
+    if(low == 0 || !extent_contains(&vfat->extents[low - 1], cluster)) return NULL;
+
+    vfat->last_extent = low - 1;
+    return &vfat->extents[low - 1];
+}
+
+// Store one FAT12 entry into a FAT window starting at byte window_start
+// Entries are 1.5 bytes, so an entry can straddle the window edges
+static void put_fat12_entry(
+    uint8_t* buffer,
+    uint32_t window_start,
+    uint32_t window_size,
+    uint32_t cluster,
+    uint32_t value) {
+    uint32_t offset = cluster + cluster / 2;
+    uint8_t lo, hi, lo_mask, hi_mask;
+    if(cluster & 1) {
+        lo = (value << 4) & 0xF0;
+        hi = (value >> 4) & 0xFF;
+        lo_mask = 0xF0;
+        hi_mask = 0xFF;
+    } else {
+        lo = value & 0xFF;
+        hi = (value >> 8) & 0x0F;
+        lo_mask = 0xFF;
+        hi_mask = 0x0F;
+    }
+
+    if(offset >= window_start && offset < window_start + window_size) {
+        uint8_t* byte = &buffer[offset - window_start];
+        *byte = (*byte & ~lo_mask) | lo;
+    }
+    if(offset + 1 >= window_start && offset + 1 < window_start + window_size) {
+        uint8_t* byte = &buffer[offset + 1 - window_start];
+        *byte = (*byte & ~hi_mask) | hi;
+    }
+}
+
+// Render count consecutive FAT sectors starting at fat_sector in one pass
+// The window of entries is intersected with the sorted extents, chains are
+// filled arithmetically, and everything past the last allocated cluster is zero
+static void render_fat_sectors(
+    VirtualFat* vfat,
+    uint32_t fat_sector,
+    uint32_t count,
+    uint8_t* buffer) {
+    VirtualFatType fat_type = vfat->layout.fat_type;
+    uint32_t window_start = fat_sector * SECTOR_SIZE;
+    uint32_t window_size = count * SECTOR_SIZE;
+
+    // Entries touching the window (FAT12 entries may start in the previous sector)
+    uint32_t first_entry;
+    uint32_t end_entry;
+    uint32_t end_of_chain;
+    if(fat_type == VIRTUAL_FAT_TYPE_FAT12) {
+        first_entry = window_start * 2 / 3;
+        end_entry = ((window_start + window_size) * 2 + 2) / 3;
+        end_of_chain = 0x0FFF;
+    } else if(fat_type == VIRTUAL_FAT_TYPE_FAT16) {
+        first_entry = window_start / 2;
+        end_entry = (window_start + window_size) / 2;
+        end_of_chain = 0xFFFF;
+    } else {
+        first_entry = window_start / 4;
+        end_entry = (window_start + window_size) / 4;
+        end_of_chain = 0x0FFFFFFF;
+    }
+
+    memset(buffer, 0, window_size);
 
-        // Write LFN entries if long name exists
-        if(file->long_name[0] != '\0') {
-            uint8_t lfn_len = strlen(file->long_name);
-            uint8_t lfn_entries = (lfn_len + 12) / 13;
-            uint8_t checksum = lfn_checksum(file->name);
-
-            for(int8_t j = lfn_entries; j >= 1 && entry_count < (SECTOR_SIZE / 32); j--) {
-                uint8_t seq = j;
-                if(j == lfn_entries) seq |= LFN_LAST;
-                write_lfn_entry(entry, seq, file->long_name, checksum);
-                entry += 32;
-                entry_count++;
+    // First FAT sector has special entries
+    if(fat_sector == 0) {
+        if(fat_type == VIRTUAL_FAT_TYPE_FAT32) {
+            uint32_t* fat = (uint32_t*)buffer;
+            fat[0] = 0x0FFFFFF8; // Media descriptor
+            fat[1] = 0x0FFFFFFF; // End of chain marker
+            fat[2] = 0x0FFFFFFF; // Root directory (cluster 2) - end of chain
+        } else if(fat_type == VIRTUAL_FAT_TYPE_FAT16) {
+            uint16_t* fat = (uint16_t*)buffer;
+            fat[0] = 0xFFF8; // Media descriptor
+            fat[1] = 0xFFFF; // End of chain marker
+        } else {
+            put_fat12_entry(buffer, window_start, window_size, 0, 0x0FF8);
+            put_fat12_entry(buffer, window_start, window_size, 1, 0x0FFF);
+        }
+    }
+
+    // Nothing allocated beyond next_cluster
+    if(first_entry >= vfat->next_cluster) return;
+
+    // Binary search for the first extent ending after the window start
+    uint16_t low = 0;
+    uint16_t high = vfat->extent_count;
+    while(low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        const VirtualFatExtent* extent = &vfat->extents[mid];
+        if(extent->start_cluster + extent->cluster_count <= first_entry) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    for(uint16_t i = low; i < vfat->extent_count; i++) {
+        const VirtualFatExtent* extent = &vfat->extents[i];
+        if(extent->start_cluster >= end_entry) break;
+
+        uint32_t extent_end = extent->start_cluster + extent->cluster_count;
+        uint32_t from = MAX(extent->start_cluster, first_entry);
+        uint32_t to = MIN(extent_end, end_entry);
+
+        // Each entry points to the next cluster of the contiguous chain,
+        // the last cluster of the extent terminates it
+        if(fat_type == VIRTUAL_FAT_TYPE_FAT32) {
+            uint32_t* entry = &((uint32_t*)buffer)[from - first_entry];
+            for(uint32_t cluster = from + 1; cluster <= to; cluster++) {
+                *entry++ = cluster;
+            }
+            if(to == extent_end) *(entry - 1) = end_of_chain;
+        } else if(fat_type == VIRTUAL_FAT_TYPE_FAT16) {
+            uint16_t* entry = &((uint16_t*)buffer)[from - first_entry];
+            for(uint32_t cluster = from + 1; cluster <= to; cluster++) {
+                *entry++ = cluster;
+            }
+            if(to == extent_end) *(entry - 1) = end_of_chain;
+        } else {
+            for(uint32_t cluster = from; cluster < to; cluster++) {
+                uint32_t next = (cluster + 1 == extent_end) ? end_of_chain : cluster + 1;
+                put_fat12_entry(buffer, window_start, window_size, cluster, next);
             }
         }
+    }
+}
+
+// Read a run of consecutive sectors of one file with a single memcpy / SD read
+// Returns number of sectors written to buffer, 0 on error
+static uint32_t read_file_run(
+    Storage* storage,
+    VirtualFat* vfat,
+    uint16_t index,
+    uint32_t file_sector,
+    uint32_t count,
+    uint8_t* buffer) {
+    VirtualFatFile* file = &vfat->files[index];
+    uint32_t offset = file_sector * SECTOR_SIZE;
+
+    FURI_LOG_I(
+        TAG,
+        "Reading file %.11s at offset %lu, sectors %lu, size %lu",
+        file->name,
+        offset,
+        count,
+        file->size);
+
+    // Trigger callback if set (only on first sector of file to avoid spam)
+    if(vfat->read_callback && offset == 0) {
+        const char* display_name = file->long_name != 0 ? pool_str(vfat, file->long_name) : NULL;
+        if(display_name == NULL) {
+            // Fallback to 8.3 name
+            static char short_name_buf[13];
+            snprintf(
+                short_name_buf, sizeof(short_name_buf), "%.8s.%.3s", file->name, file->name + 8);
+            display_name = short_name_buf;
+        }
+        vfat->read_callback(display_name, vfat->callback_context);
+    }
 
-        // Write 8.3 directory entry
-        uint8_t attributes = file->is_directory ? 0x10 : 0x20;
-        write_directory_entry(entry, file->name, attributes, file->start_cluster, file->size);
+    uint32_t run_size = count * SECTOR_SIZE;
+    uint32_t copy_size = 0;
+    if(offset < file->size) {
+        copy_size = file->size - offset;
+        if(copy_size > run_size) copy_size = run_size;
+    }
+
+    // Zero the slack after end of file
+    memset(buffer + copy_size, 0, run_size - copy_size);
+
+    if(copy_size == 0) return count;
 
-        entry += 32;
-        entry_count++;
+    if(file->source_type == FILE_SOURCE_MEMORY) {
+        // Read from RAM
+        FURI_LOG_D(TAG, "Reading %lu bytes from memory at offset %lu", copy_size, offset);
+        memcpy(buffer, file->memory_data + offset, copy_size);
+    } else if(file->source_type == FILE_SOURCE_SD_CARD) {
+        // Stream from SD card, whole run in one read
+        vfat->stats.sd_sectors += count;
+        if(!read_sd_file(storage, vfat, index, offset, buffer, copy_size)) {
+            return 0;
+        }
+    } else if(file->source_type == FILE_SOURCE_SD_PACKED) {
+        // Decode the packed blocks the run touches
+        vfat->stats.sd_sectors += count;
+        if(!read_packed_file(storage, vfat, index, offset, buffer, copy_size)) {
+            return 0;
+        }
     }
+
+    return count;
 }
 
-bool virtual_fat_read_sector(Storage* storage, VirtualFat* vfat, uint32_t lba, uint8_t* buffer) {
-    if(vfat == NULL || buffer == NULL) return false;
+// Read one metadata sector, or a contiguous run of up to max_count FAT or file sectors
+// Returns number of sectors written to buffer, 0 on error
+static uint32_t read_sector_run(
+    Storage* storage,
+    VirtualFat* vfat,
+    uint32_t lba,
+    uint32_t max_count,
+    uint8_t* buffer) {
+    // Index is built on first read if the caller did not seal explicitly
+    if(!vfat->sealed && !virtual_fat_seal(vfat)) {
+        return 0;
+    }
 
     // Log which sectors are being read
     static uint32_t last_logged_lba = 0xFFFFFFFF;
@@ -846,256 +1978,292 @@ bool virtual_fat_read_sector(Storage* storage, VirtualFat* vfat, uint32_t lba, u
         last_logged_lba = lba;
     }
 
-    // Partition size depends on scheme (use macros from virtual_fat.h)
-    const uint32_t PARTITION_SECTORS = (vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) ?
-                                           PARTITION_SECTORS_GPT :
-                                           PARTITION_SECTORS_MBR;
+    // Metadata sectors rendered at seal time
+    if(metadata_cache_read(vfat, lba, buffer)) {
+        return 1;
+    }
 
-    uint32_t cluster_count = PARTITION_SECTORS / SECTORS_PER_CLUSTER;
-    uint32_t fat_size = ((cluster_count * 4) + SECTOR_SIZE - 1) / SECTOR_SIZE;
-    uint32_t fat1_start = PARTITION_START + RESERVED_SECTORS;
-    uint32_t fat2_start = fat1_start + fat_size;
-    uint32_t data_start = fat2_start + fat_size;
+    const VirtualFatLayout* layout = &vfat->layout;
 
     // LBA 0: MBR or Protective MBR depending on partition scheme
     if(lba == 0) {
         if(vfat->partition_scheme == PARTITION_SCHEME_MBR_ONLY) {
-            // MBR only - bootable FAT32 partition
-            generate_mbr(buffer, PARTITION_START, PARTITION_SECTORS, 0xEF);
+            // MBR only - bootable partition, typed after the FAT
+            uint8_t partition_type = layout->fat_type == VIRTUAL_FAT_TYPE_FAT16 ?
+                                         MBR_TYPE_FAT16_LBA :
+                                     layout->fat_type == VIRTUAL_FAT_TYPE_FAT12 ?
+                                         MBR_TYPE_FAT12 :
+                                         MBR_TYPE_EFI;
+            generate_mbr(buffer, PARTITION_START, layout->partition_sectors, partition_type);
             FURI_LOG_D(TAG, "Generated MBR (MBR-only mode)");
         } else {
             // GPT only - protective MBR
-            generate_protective_mbr(buffer, TOTAL_SECTORS);
+            generate_protective_mbr(buffer, layout->total_sectors);
             FURI_LOG_D(TAG, "Generated Protective MBR (GPT mode)");
         }
-        return true;
+        return 1;
     }
 
     // LBA 1: GPT Header (only in GPT mode)
     if(lba == 1) {
-        if(vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) {
-            generate_gpt_header(buffer, TOTAL_SECTORS, PARTITION_START, PARTITION_SECTORS);
-            FURI_LOG_D(TAG, "Generated GPT header at LBA 1");
+        if(vfat->gpt_cache != NULL) {
+            memcpy(buffer, vfat->gpt_cache + GPT_CACHE_HEADER * SECTOR_SIZE, SECTOR_SIZE);
         } else {
             // MBR mode: no GPT header
             memset(buffer, 0, SECTOR_SIZE);
         }
-        return true;
+        return 1;
     }
 
     // LBA 2: GPT Partition Entry Array (only in GPT mode)
     if(lba == 2) {
-        if(vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) {
-            generate_gpt_partitions(buffer, PARTITION_START, PARTITION_SECTORS);
-            FURI_LOG_D(TAG, "Generated GPT partitions at LBA 2");
+        if(vfat->gpt_cache != NULL) {
+            memcpy(buffer, vfat->gpt_cache + GPT_CACHE_PARTITIONS * SECTOR_SIZE, SECTOR_SIZE);
         } else {
             // MBR mode: no GPT partitions
             memset(buffer, 0, SECTOR_SIZE);
         }
-        return true;
+        return 1;
     }
 
     // Empty sectors between GPT and partition (LBA 3 to PARTITION_START-1)
     if(lba > 2 && lba < PARTITION_START) {
         memset(buffer, 0, SECTOR_SIZE);
-        return true;
+        return 1;
     }
 
     // Backup GPT structures (only in GPT mode)
-    if(vfat->partition_scheme == PARTITION_SCHEME_GPT_ONLY) {
+    if(vfat->gpt_cache != NULL) {
+        uint32_t backup_array_start = GPT_BACKUP_ARRAY_START(layout->total_sectors);
+        uint32_t backup_header = GPT_BACKUP_HEADER(layout->total_sectors);
+
         // Backup GPT partition array: starts at GPT_BACKUP_ARRAY_START
-        if(lba >= GPT_BACKUP_ARRAY_START && lba < GPT_BACKUP_HEADER) {
+        if(lba >= backup_array_start && lba < backup_header) {
             // Only first sector of backup partition array has data (like primary)
-            if(lba == GPT_BACKUP_ARRAY_START) {
-                generate_gpt_backup_partitions(buffer, PARTITION_START, PARTITION_SECTORS);
-                FURI_LOG_D(TAG, "Generated backup GPT partitions at LBA %lu", lba);
+            if(lba == backup_array_start) {
+                memcpy(buffer, vfat->gpt_cache + GPT_CACHE_PARTITIONS * SECTOR_SIZE, SECTOR_SIZE);
             } else {
                 memset(buffer, 0, SECTOR_SIZE);
             }
-            return true;
+            return 1;
         }
 
         // Backup GPT header: GPT_BACKUP_HEADER
-        if(lba == GPT_BACKUP_HEADER) {
-            generate_gpt_backup_header(buffer, TOTAL_SECTORS, PARTITION_START, PARTITION_SECTORS);
-            FURI_LOG_D(TAG, "Generated backup GPT header at LBA %lu", lba);
-            return true;
+        if(lba == backup_header) {
+            memcpy(buffer, vfat->gpt_cache + GPT_CACHE_BACKUP_HEADER * SECTOR_SIZE, SECTOR_SIZE);
+            return 1;
         }
     }
 
     // Boot sector at partition start
     if(lba == PARTITION_START) {
-        generate_boot_sector(buffer, PARTITION_SECTORS);
-        return true;
+        generate_boot_sector(buffer, layout);
+        return 1;
     }
 
-    // FS Info sector at LBA 2
-    if(lba == PARTITION_START + 1) {
-        generate_fsinfo_sector(buffer);
-        return true;
-    }
+    // FAT32 only: FS Info sector and backups in the reserved area
+    if(layout->fat_type == VIRTUAL_FAT_TYPE_FAT32) {
+        // FS Info sector at LBA 2
+        if(lba == PARTITION_START + 1) {
+            generate_fsinfo_sector(buffer);
+            return 1;
+        }
 
-    // Backup boot sector at LBA 7 (6 sectors after partition start)
-    if(lba == PARTITION_START + 6) {
-        generate_boot_sector(buffer, PARTITION_SECTORS);
-        return true;
-    }
+        // Backup boot sector at LBA 7 (6 sectors after partition start)
+        if(lba == PARTITION_START + 6) {
+            generate_boot_sector(buffer, layout);
+            return 1;
+        }
 
-    // Backup FS Info sector at LBA 8
-    if(lba == PARTITION_START + 7) {
-        generate_fsinfo_sector(buffer);
-        return true;
+        // Backup FS Info sector at LBA 8
+        if(lba == PARTITION_START + 7) {
+            generate_fsinfo_sector(buffer);
+            return 1;
+        }
     }
 
     // Other reserved sectors (empty)
-    if(lba < fat1_start) {
+    if(lba < layout->fat1_start) {
         memset(buffer, 0, SECTOR_SIZE);
-        return true;
+        return 1;
     }
 
     // FAT1
-    if(lba >= fat1_start && lba < fat2_start) {
-        generate_fat_sector(vfat, lba - fat1_start, buffer);
-        return true;
+    if(lba >= layout->fat1_start && lba < layout->fat2_start) {
+        uint32_t run = MIN(max_count, layout->fat2_start - lba);
+        render_fat_sectors(vfat, lba - layout->fat1_start, run, buffer);
+        return run;
     }
 
     // FAT2 (copy of FAT1)
-    if(lba >= fat2_start && lba < data_start) {
-        generate_fat_sector(vfat, lba - fat2_start, buffer);
-        return true;
+    if(lba >= layout->fat2_start && lba < layout->root_start) {
+        uint32_t run = MIN(max_count, layout->root_start - lba);
+        render_fat_sectors(vfat, lba - layout->fat2_start, run, buffer);
+        return run;
+    }
+
+    // Fixed root directory region (FAT12/FAT16 only, empty range on FAT32)
+    if(lba >= layout->root_start && lba < layout->data_start) {
+        generate_directory_sector(vfat, -1, lba - layout->root_start, buffer);
+        return 1;
     }
 
     // Data area
-    if(lba >= data_start) {
-        uint32_t cluster_offset = (lba - data_start) / SECTORS_PER_CLUSTER;
-        uint32_t sector_in_cluster = (lba - data_start) % SECTORS_PER_CLUSTER;
-        uint32_t cluster_num = cluster_offset + 2; // FAT clusters start at 2
-
-        // Root directory is cluster 2
-        if(cluster_num == 2 && sector_in_cluster == 0) {
-            generate_root_directory(vfat, buffer);
-            return true;
-        }
+    if(lba >= layout->data_start) {
+        uint32_t data_sector = lba - layout->data_start;
+        uint32_t cluster_num =
+            data_sector / layout->sectors_per_cluster + 2; // FAT clusters start at 2
 
         // Find which file/directory this cluster belongs to
-        for(uint8_t i = 0; i < vfat->file_count; i++) {
-            VirtualFatFile* file = &vfat->files[i];
-
-            // Check if this is a directory cluster
-            if(file->is_directory && cluster_num == file->start_cluster &&
-               sector_in_cluster == 0) {
-                generate_subdirectory(vfat, i, buffer);
-                return true;
+        const VirtualFatExtent* extent = find_extent(vfat, cluster_num);
+        if(extent != NULL) {
+            uint32_t file_sector =
+                data_sector - (extent->start_cluster - 2) * layout->sectors_per_cluster;
+
+            // FAT32 root directory
+            if(extent->file_index == ROOT_INDEX) {
+                generate_directory_sector(vfat, -1, file_sector, buffer);
+                return 1;
             }
 
-            // For regular files, check cluster range
-            if(!file->is_directory) {
-                uint32_t file_clusters = (file->size + (SECTORS_PER_CLUSTER * SECTOR_SIZE) - 1) /
-                                         (SECTORS_PER_CLUSTER * SECTOR_SIZE);
-
-                if(cluster_num >= file->start_cluster &&
-                   cluster_num < file->start_cluster + file_clusters) {
-                    // This sector belongs to this file
-                    uint32_t file_cluster = cluster_num - file->start_cluster;
-                    uint32_t file_sector = file_cluster * SECTORS_PER_CLUSTER + sector_in_cluster;
-                    uint32_t offset = file_sector * SECTOR_SIZE;
-
-                    FURI_LOG_I(
-                        TAG,
-                        "Reading file %.11s at cluster %lu, offset %lu, size %lu",
-                        file->name,
-                        cluster_num,
-                        offset,
-                        file->size);
-
-                    // Trigger callback if set (only on first sector of file to avoid spam)
-                    if(vfat->read_callback && offset == 0) {
-                        const char* display_name = file->long_name[0] != '\0' ? file->long_name :
-                                                                                NULL;
-                        if(display_name == NULL) {
-                            // Fallback to 8.3 name
-                            static char short_name_buf[13];
-                            snprintf(
-                                short_name_buf,
-                                sizeof(short_name_buf),
-                                "%.8s.%.3s",
-                                file->name,
-                                file->name + 8);
-                            display_name = short_name_buf;
-                        }
-                        vfat->read_callback(display_name, vfat->callback_context);
-                    }
-
-                    memset(buffer, 0, SECTOR_SIZE);
-
-                    if(offset < file->size) {
-                        uint32_t copy_size = file->size - offset;
-                        if(copy_size > SECTOR_SIZE) copy_size = SECTOR_SIZE;
-
-                        if(file->source_type == FILE_SOURCE_MEMORY) {
-                            // Read from RAM
-                            FURI_LOG_D(
-                                TAG,
-                                "Reading %lu bytes from memory at offset %lu",
-                                copy_size,
-                                offset);
-                            memcpy(buffer, file->memory_data + offset, copy_size);
-                        } else if(file->source_type == FILE_SOURCE_SD_CARD) {
-                            // Stream from SD card
-                            File* sd_file = storage_file_alloc(storage);
-
-                            if(storage_file_open(
-                                   sd_file,
-                                   furi_string_get_cstr(file->sd_path),
-                                   FSAM_READ,
-                                   FSOM_OPEN_EXISTING)) {
-                                storage_file_seek(sd_file, offset, true);
-                                uint16_t bytes_read =
-                                    storage_file_read(sd_file, buffer, copy_size);
-                                if(bytes_read != copy_size) {
-                                    FURI_LOG_W(
-                                        TAG,
-                                        "SD read mismatch: expected %lu, got %u",
-                                        copy_size,
-                                        bytes_read);
-                                }
-                                storage_file_close(sd_file);
-                            } else {
-                                FURI_LOG_E(
-                                    TAG,
-                                    "Failed to open SD file: %s",
-                                    furi_string_get_cstr(file->sd_path));
-                            }
-
-                            storage_file_free(sd_file);
-                        }
-                    }
-
-                    return true;
-                }
+            // Directory cluster
+            if(vfat->files[extent->file_index].is_directory) {
+                generate_directory_sector(vfat, extent->file_index, file_sector, buffer);
+                return 1;
             }
+
+            // Regular file: extend the run up to the end of the extent
+            uint32_t run = extent->cluster_count * layout->sectors_per_cluster - file_sector;
+            if(run > max_count) run = max_count;
+
+            return read_file_run(storage, vfat, extent->file_index, file_sector, run, buffer);
         }
 
         // Empty sector
         memset(buffer, 0, SECTOR_SIZE);
-        return true;
+        return 1;
     }
 
-    return false;
+    return 0;
+}
+
+bool virtual_fat_read_sector(Storage* storage, VirtualFat* vfat, uint32_t lba, uint8_t* buffer) {
+    if(vfat == NULL || buffer == NULL) return false;
+    return read_sector_run(storage, vfat, lba, 1, buffer) == 1;
+}
+
+bool virtual_fat_read_sectors(
+    Storage* storage,
+    VirtualFat* vfat,
+    uint32_t lba,
+    uint32_t count,
+    uint8_t* buffer) {
+    if(vfat == NULL || buffer == NULL) return false;
+
+    while(count > 0) {
+        uint32_t run = read_sector_run(storage, vfat, lba, count, buffer);
+        if(run == 0) {
+            FURI_LOG_E(TAG, "Failed to read sector %lu", lba);
+            return false;
+        }
+
+        lba += run;
+        count -= run;
+        buffer += run * SECTOR_SIZE;
+    }
+
+    return true;
+}
+
+void virtual_fat_get_stats(VirtualFat* vfat, VirtualFatStats* stats) {
+    if(vfat == NULL || stats == NULL) return;
+    *stats = vfat->stats;
+}
+
+void virtual_fat_for_each_file_range(
+    VirtualFat* vfat,
+    VirtualFatFileRangeCallback callback,
+    void* context) {
+    if(vfat == NULL || callback == NULL) return;
+    if(!vfat->sealed && !virtual_fat_seal(vfat)) return;
+
+    const VirtualFatLayout* layout = &vfat->layout;
+    for(uint16_t i = 0; i < vfat->file_count; i++) {
+        const VirtualFatFile* file = &vfat->files[i];
+        if(file->is_directory || file->start_cluster == 0) continue;
+
+        uint32_t lba =
+            layout->data_start + (file->start_cluster - 2) * layout->sectors_per_cluster;
+        callback(file, lba, (file->size + SECTOR_SIZE - 1) / SECTOR_SIZE, context);
+    }
 }
 
 uint32_t virtual_fat_get_total_sectors(VirtualFat* vfat) {
-    UNUSED(vfat);
-    return TOTAL_SECTORS;
+    if(vfat == NULL) return 0;
+    if(!vfat->sealed && !virtual_fat_seal(vfat)) return 0;
+    return vfat->layout.total_sectors;
 }
 
 void virtual_fat_set_partition_scheme(VirtualFat* vfat, PartitionScheme scheme) {
     if(vfat == NULL) return;
+    if(vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot change partition scheme: filesystem already sealed");
+        return;
+    }
     vfat->partition_scheme = scheme;
     FURI_LOG_I(
         TAG, "Partition scheme set to: %s", scheme == PARTITION_SCHEME_MBR_ONLY ? "MBR" : "GPT");
 }
 
+void virtual_fat_set_min_total_sectors(VirtualFat* vfat, uint32_t sectors) {
+    if(vfat == NULL) return;
+    if(vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot change disk size: filesystem already sealed");
+        return;
+    }
+    vfat->min_total_sectors = sectors;
+}
+
+void virtual_fat_set_fat_type(VirtualFat* vfat, VirtualFatType type) {
+    if(vfat == NULL) return;
+    if(vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot change FAT type: filesystem already sealed");
+        return;
+    }
+    vfat->fat_type = type;
+}
+
+VirtualFatType virtual_fat_get_fat_type(VirtualFat* vfat) {
+    if(vfat == NULL || !vfat->sealed) return VIRTUAL_FAT_TYPE_AUTO;
+    return vfat->layout.fat_type;
+}
+
+void virtual_fat_set_sectors_per_cluster(VirtualFat* vfat, uint8_t sectors_per_cluster) {
+    if(vfat == NULL) return;
+    if(vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot change cluster size: filesystem already sealed");
+        return;
+    }
+
+    // Must be a power of two no larger than SECTORS_PER_CLUSTER_MAX
+    if(sectors_per_cluster > SECTORS_PER_CLUSTER_MAX ||
+       (sectors_per_cluster & (sectors_per_cluster - 1)) != 0) {
+        FURI_LOG_W(TAG, "Invalid cluster size %u, using automatic", sectors_per_cluster);
+        sectors_per_cluster = SECTORS_PER_CLUSTER_AUTO;
+    }
+
+    vfat->sectors_per_cluster = sectors_per_cluster;
+}
+
+void virtual_fat_set_metadata_cache_limit(VirtualFat* vfat, size_t limit) {
+    if(vfat == NULL) return;
+    if(vfat->sealed) {
+        FURI_LOG_E(TAG, "Cannot change metadata cache limit: filesystem already sealed");
+        return;
+    }
+    vfat->metadata_cache_limit = limit;
+}
+
 void virtual_fat_set_read_callback(
     VirtualFat* vfat,
     VirtualFatFileReadCallback callback,
@@ -1104,3 +2272,40 @@ void virtual_fat_set_read_callback(
     vfat->read_callback = callback;
     vfat->callback_context = context;
 }
+
+// Block device adapter, Storage is bound when the device is allocated
+typedef struct {
+    VirtualFat* vfat;
+    Storage* storage;
+} VirtualFatBlockContext;
+
+static bool virtual_fat_block_get_geometry(void* context, BlockDeviceGeometry* geometry) {
+    VirtualFatBlockContext* block = context;
+    geometry->block_count = virtual_fat_get_total_sectors(block->vfat);
+    geometry->block_size = SECTOR_SIZE;
+    return geometry->block_count != 0;
+}
+
+static bool
+    virtual_fat_block_read(void* context, uint32_t lba, uint32_t count, uint8_t* buffer) {
+    VirtualFatBlockContext* block = context;
+    return virtual_fat_read_sectors(block->storage, block->vfat, lba, count, buffer);
+}
+
+static const BlockDeviceApi virtual_fat_block_api = {
+    .get_geometry = virtual_fat_block_get_geometry,
+    .read_blocks = virtual_fat_block_read,
+    .write_blocks = NULL,
+    .prefetch = NULL,
+    .free = free,
+};
+
+BlockDevice* virtual_fat_block_device_alloc(VirtualFat* vfat, Storage* storage) {
+    if(vfat == NULL) return NULL;
+
+    VirtualFatBlockContext* block = malloc(sizeof(VirtualFatBlockContext));
+    block->vfat = vfat;
+    block->storage = storage;
+
+    return block_device_alloc(&virtual_fat_block_api, block);
+}
@@ -2,30 +2,52 @@
 
 #include <furi.h>
 #include <storage/storage.h>
+#include "block_device.h"
 
 /**
  * Virtual FAT filesystem - generates FAT structures on-the-fly
  * No disk image file needed, everything generated in memory per SCSI read
  */
 
-#define SECTOR_SIZE         512
-#define SECTORS_PER_CLUSTER 1 // 1 sector/cluster for volumes ≤ 260MB (FAT32 spec)
-#define TOTAL_SECTORS       262144 // 128MB disk (meets UEFI ESP minimum size)
-#define RESERVED_SECTORS    32
-#define FAT_COPIES          2
+#define RESERVED_SECTORS 32
+
+// Disk size floors, the disk grows beyond them to fit the registered files
+#define MIN_TOTAL_SECTORS_GPT 262144 // 128MB (meets UEFI ESP minimum size)
+#define MIN_TOTAL_SECTORS_MBR 65536 // 32MB (BIOS boot has no ESP size requirement)
+#define FAT_COPIES 2
+
+// Largest Min_Disk_Size, sector numbers are 32-bit
+#define MAX_DISK_SIZE_MB (UINT32_MAX / (1024 * 1024 / SECTOR_SIZE))
+
+// Cluster size
+#define SECTORS_PER_CLUSTER_AUTO 0 // Largest cluster that still gives a valid volume
+#define SECTORS_PER_CLUSTER_MAX  64 // 32KB, the largest cluster size all hosts accept
+
+// FAT type is decided by cluster count alone (FAT spec)
+#define FAT12_MAX_CLUSTERS       4084
+#define FAT16_MAX_CLUSTERS       65524
+#define FAT32_MIN_CLUSTERS       (FAT16_MAX_CLUSTERS + 1)
+#define FAT16_MIN_CLUSTERS       (FAT12_MAX_CLUSTERS + 1)
+#define FAT12_MAX_VOLUME_SECTORS 32768 // Automatic type selection uses FAT12 below 16MB
+#define FAT_ROOT_ENTRIES         512 // Fixed root directory region of FAT12/FAT16
 
 // Partition layout constants
 #define PARTITION_START        2048 // 1MB alignment for macOS compatibility
 #define GPT_BACKUP_SECTORS     33 // Backup GPT: 32 sectors array + 1 header
 #define GPT_FIRST_USABLE       34 // First usable LBA (after primary GPT array)
-#define GPT_LAST_USABLE        (TOTAL_SECTORS - GPT_BACKUP_SECTORS - 1) // Last usable LBA
-#define GPT_BACKUP_ARRAY_START (TOTAL_SECTORS - GPT_BACKUP_SECTORS) // Backup partition array LBA
-#define GPT_BACKUP_HEADER      (TOTAL_SECTORS - 1) // Backup GPT header LBA
+#define GPT_LAST_USABLE(total) ((total) - GPT_BACKUP_SECTORS - 1) // Last usable LBA
+#define GPT_BACKUP_ARRAY_START(total) \
+    ((total) - GPT_BACKUP_SECTORS) // Backup partition array LBA
+#define GPT_BACKUP_HEADER(total) ((total) - 1) // Backup GPT header LBA
+
+// Default memory cap for the sealed metadata sector cache (bytes)
+#define VIRTUAL_FAT_METADATA_CACHE_LIMIT (8 * SECTOR_SIZE)
 
 // Partition sizes (mode-dependent)
-#define PARTITION_SECTORS_MBR (TOTAL_SECTORS - PARTITION_START) // MBR: use all remaining sectors
-#define PARTITION_SECTORS_GPT \
-    (GPT_LAST_USABLE - PARTITION_START + 1) // GPT: reserve space for backup GPT
+#define PARTITION_SECTORS_MBR(total) \
+    ((total) - PARTITION_START) // MBR: use all remaining sectors
+#define PARTITION_SECTORS_GPT(total) \
+    (GPT_LAST_USABLE(total) - PARTITION_START + 1) // GPT: reserve space for backup GPT
 
 /**
  * Partition table scheme
@@ -35,6 +57,16 @@ typedef enum {
     PARTITION_SCHEME_GPT_ONLY, // GPT (UEFI boot)
 } PartitionScheme;
 
+/**
+ * FAT type of the generated volume
+ */
+typedef enum {
+    VIRTUAL_FAT_TYPE_AUTO, // FAT32 for GPT, FAT16 (FAT12 when small) for MBR
+    VIRTUAL_FAT_TYPE_FAT12,
+    VIRTUAL_FAT_TYPE_FAT16,
+    VIRTUAL_FAT_TYPE_FAT32,
+} VirtualFatType;
+
 typedef struct VirtualFat VirtualFat;
 
 /**
@@ -50,25 +82,55 @@ typedef void (*VirtualFatFileReadCallback)(const char* filename, void* context);
 typedef enum {
     FILE_SOURCE_MEMORY, // Data stored in RAM
     FILE_SOURCE_SD_CARD, // Data streamed from SD card file
+    FILE_SOURCE_SD_PACKED, // Data decoded from a packed SD card file (see packed_file.h)
 } FileSourceType;
 
 /**
  * File entry in virtual filesystem
+ * Long names and SD paths are interned in the filesystem's string pool,
+ * which keeps an entry at 32 bytes
  */
 typedef struct {
     char name[11]; // 8.3 filename (padded with spaces)
-    char long_name[256]; // VFAT long filename (null-terminated UTF-8)
+    uint8_t source_type; // FileSourceType, where data comes from
+    bool is_directory; // If true, this is a directory entry
+    int16_t parent_index; // Index of parent directory (-1 for root)
+    uint32_t long_name; // String pool offset of VFAT long filename (UTF-8, "" if none)
     uint32_t size; // File size in bytes
-    uint32_t start_cluster; // Starting cluster number
-    FileSourceType source_type; // Where data comes from
+    uint32_t start_cluster; // Starting cluster number (assigned by virtual_fat_seal)
     union {
         const uint8_t* memory_data; // For FILE_SOURCE_MEMORY
-        FuriString* sd_path; // For FILE_SOURCE_SD_CARD
+        uint32_t sd_path; // For FILE_SOURCE_SD_CARD, string pool offset
     };
-    bool is_directory; // If true, this is a directory entry
-    int8_t parent_index; // Index of parent directory (-1 for root)
 } VirtualFatFile;
 
+/**
+ * Callback function type for virtual_fat_for_each_file_range
+ * @param file File entry
+ * @param lba First sector of the file data
+ * @param sectors Sectors holding the file data (last one may be partly used)
+ * @param context User context pointer
+ */
+typedef void (*VirtualFatFileRangeCallback)(
+    const VirtualFatFile* file,
+    uint32_t lba,
+    uint32_t sectors,
+    void* context);
+
+/**
+ * SD streaming statistics
+ * sd_opens staying at one per file while sd_reads grows proves the
+ * per-sector open/close round trips are gone (more opens than files means
+ * the handle cache is thrashing)
+ */
+typedef struct {
+    uint32_t sd_opens; // storage_file_open calls
+    uint32_t sd_seeks; // storage_file_seek calls (non-sequential reads only)
+    uint32_t sd_reads; // storage_file_read calls
+    uint32_t sd_sectors; // Data sectors served from SD-backed files
+    uint32_t packed_blocks; // Packed file blocks read and decoded
+} VirtualFatStats;
+
 /**
  * Allocate virtual FAT filesystem
  * @return VirtualFat instance
@@ -106,7 +168,9 @@ bool virtual_fat_add_text_file(VirtualFat* vfat, const char* filename, const cha
 
 /**
  * Add file from SD card to virtual filesystem
- * Data is streamed on-demand, not loaded into RAM
+ * Data is streamed on-demand, not loaded into RAM. Packed files (see
+ * packed_file.h) are detected by their header, registered with their
+ * uncompressed size and decoded block by block as they are read.
  * @param vfat Instance
  * @param filename 8.3 filename (e.g., "IPXE.LKR")
  * @param sd_path Path to file on SD card (e.g., "/ext/apps_data/boot2flipper/ipxe/ipxe.lkrn")
@@ -128,6 +192,7 @@ bool virtual_fat_add_directory(VirtualFat* vfat, const char* dirname);
 
 /**
  * Add file to subdirectory in virtual filesystem
+ * Packed files are handled as in virtual_fat_add_sd_file
  * @param vfat Instance
  * @param parent_dir Parent directory name (e.g., "EFI/BOOT")
  * @param filename 8.3 filename (e.g., "BOOTX64.EFI")
@@ -141,6 +206,38 @@ bool virtual_fat_add_file_to_subdir(
     const char* filename,
     const char* sd_path);
 
+/**
+ * Mirror an SD card directory tree into the virtual filesystem
+ * Walks the tree once with storage_dir_read, sizes come from the directory
+ * listing so no file is opened (packed files are served as is). Hidden entries
+ * (starting with '.') are skipped, directories that already exist are merged
+ * and names that already exist are skipped with a warning.
+ * @param vfat Instance
+ * @param sd_dir SD card directory (e.g., "/ext/apps_data/boot2flipper/payload")
+ * @param mount_path Directory in the virtual filesystem (e.g., "KIT"), "" for root
+ * @return true on success, false if a directory cannot be read or the
+ *         filesystem is full
+ */
+bool virtual_fat_add_sd_tree(
+    Storage* storage,
+    VirtualFat* vfat,
+    const char* sd_dir,
+    const char* mount_path);
+
+/**
+ * Seal virtual filesystem after the last virtual_fat_add_* call
+ * Sizes the disk for the registered files, resolves FAT type and cluster
+ * size, assigns clusters to every entry, builds the sorted cluster extent
+ * index used to resolve data sector reads and renders MBR/GPT, boot/FSInfo
+ * sectors and directory sectors into the metadata cache.
+ * Further virtual_fat_add_* calls fail once sealed. Reading an unsealed
+ * filesystem seals it implicitly.
+ * @param vfat Instance
+ * @return true on success, false if the files cannot be laid out or the
+ *         FAT12/FAT16 root directory exceeds FAT_ROOT_ENTRIES entries
+ */
+bool virtual_fat_seal(VirtualFat* vfat);
+
 /**
  * Read sector from virtual filesystem
  * Called by SCSI layer when host requests data
@@ -151,20 +248,111 @@ bool virtual_fat_add_file_to_subdir(
  */
 bool virtual_fat_read_sector(Storage* storage, VirtualFat* vfat, uint32_t lba, uint8_t* buffer);
 
+/**
+ * Read consecutive sectors from virtual filesystem
+ * File data is fetched in per-file contiguous runs, one SD read per run
+ * @param vfat Instance
+ * @param lba First Logical Block Address
+ * @param count Number of sectors to read
+ * @param buffer Output buffer (must be count * SECTOR_SIZE bytes)
+ * @return true on success
+ */
+bool virtual_fat_read_sectors(
+    Storage* storage,
+    VirtualFat* vfat,
+    uint32_t lba,
+    uint32_t count,
+    uint8_t* buffer);
+
 /**
  * Get total sector count
+ * Disk size is fixed at seal time, an unsealed filesystem is sealed implicitly
  * @param vfat Instance
  * @return Total sectors
  */
 uint32_t virtual_fat_get_total_sectors(VirtualFat* vfat);
 
+/**
+ * Allocate block device serving the virtual filesystem
+ * Free with block_device_free, the filesystem itself stays owned by the caller
+ * @param vfat Instance
+ * @param storage Storage instance used for SD reads
+ * @return BlockDevice instance (read-only)
+ */
+BlockDevice* virtual_fat_block_device_alloc(VirtualFat* vfat, Storage* storage);
+
+/**
+ * Get SD streaming statistics
+ * @param vfat Instance
+ * @param stats Output statistics
+ */
+void virtual_fat_get_stats(VirtualFat* vfat, VirtualFatStats* stats);
+
+/**
+ * Visit the data sectors of every non-empty regular file
+ * File data is contiguous on the volume, so callers can cache or pin hot
+ * parts of a file (e.g. PE headers). An unsealed filesystem is sealed implicitly.
+ * @param vfat Instance
+ * @param callback Called once per file, in registration order
+ * @param context User context pointer passed to callback
+ */
+void virtual_fat_for_each_file_range(
+    VirtualFat* vfat,
+    VirtualFatFileRangeCallback callback,
+    void* context);
+
 /**
  * Set partition scheme
+ * Must be called before sealing
  * @param vfat Instance
  * @param scheme Partition scheme to use
  */
 void virtual_fat_set_partition_scheme(VirtualFat* vfat, PartitionScheme scheme);
 
+/**
+ * Set minimum disk size
+ * Must be called before sealing. The disk still grows to fit large payloads.
+ * @param vfat Instance
+ * @param sectors Minimum total sectors, or 0 for the partition scheme default
+ *                (MIN_TOTAL_SECTORS_GPT / MIN_TOTAL_SECTORS_MBR)
+ */
+void virtual_fat_set_min_total_sectors(VirtualFat* vfat, uint32_t sectors);
+
+/**
+ * Set FAT type
+ * Must be called before sealing. If the volume cannot be formatted with the
+ * requested type, the closest valid type is used instead.
+ * @param vfat Instance
+ * @param type FAT type, or VIRTUAL_FAT_TYPE_AUTO
+ */
+void virtual_fat_set_fat_type(VirtualFat* vfat, VirtualFatType type);
+
+/**
+ * Get FAT type chosen at seal time
+ * @param vfat Instance
+ * @return FAT type (VIRTUAL_FAT_TYPE_AUTO if not sealed yet)
+ */
+VirtualFatType virtual_fat_get_fat_type(VirtualFat* vfat);
+
+/**
+ * Set cluster size
+ * Must be called before sealing. Sizes that would leave too few clusters for
+ * the FAT type are reduced to the largest valid size.
+ * @param vfat Instance
+ * @param sectors_per_cluster Power of two up to SECTORS_PER_CLUSTER_MAX,
+ *                            or SECTORS_PER_CLUSTER_AUTO
+ */
+void virtual_fat_set_sectors_per_cluster(VirtualFat* vfat, uint8_t sectors_per_cluster);
+
+/**
+ * Set memory cap of the metadata sector cache
+ * Must be called before sealing. Metadata sectors that do not fit are
+ * rendered on demand instead. 0 disables the cache.
+ * @param vfat Instance
+ * @param limit Cache size limit in bytes
+ */
+void virtual_fat_set_metadata_cache_limit(VirtualFat* vfat, size_t limit);
+
 /**
  * Set callback for file read events
  * @param vfat Instance
@@ -345,7 +345,11 @@ static void Home_enter_callback(void* context, uint32_t index) {
             furi_string_get_cstr(app->config->chainload_url),
             furi_string_get_cstr(app->config->network_interface),
             app->config->partition_scheme,
-            app->config->chainload_enabled);
+            app->config->chainload_enabled,
+            app->config->sectors_per_cluster,
+            app->config->min_disk_size_mb,
+            furi_string_get_cstr(app->config->image_path),
+            app->config->write_overlay_sectors);
 
         scene_manager_next_scene(app->scene_manager, UsbMassStorage);
         break;
@@ -5,9 +5,16 @@
 #include "../../disk/virtual_fat.h"
 #include "../../usb/usb_scsi.h"
 #include "../../usb/usb_msc.h"
+#include <string.h>
 
 #define THIS_SCENE UsbMassStorage
 
+// Optional offline boot kit, mirrored into the volume root when present
+#define PAYLOAD_DIR_PATH EXT_PATH("apps_data/boot2flipper/payload")
+
+// Sectors pinned in the cache at each end of EFI binaries
+#define EFI_PIN_SECTORS 8
+
 static void usb_mass_storage_draw_callback(Canvas* canvas, void* model) {
     AppUsbMassStorage** instance_ptr = (AppUsbMassStorage**)model;
     AppUsbMassStorage* instance = *instance_ptr;
@@ -145,6 +152,12 @@ AppUsbMassStorage* UsbMassStorage_alloc() {
     instance->state = UsbMassStorageStateIdle;
     instance->usb_thread = NULL;
     instance->vfat = NULL;
+    instance->raw_image = NULL;
+    instance->device = NULL;
+    instance->prefetcher = NULL;
+    instance->cache = NULL;
+    instance->cache_device = NULL;
+    instance->overlay = NULL;
     instance->scsi = NULL;
     instance->msc = NULL;
 
@@ -156,7 +169,9 @@ AppUsbMassStorage* UsbMassStorage_alloc() {
     instance->network_interface = furi_string_alloc();
     instance->status_text = furi_string_alloc();
     instance->current_file = furi_string_alloc();
+    instance->image_path = furi_string_alloc();
     instance->chainload_enabled = true; // Default: enabled
+    instance->write_overlay_sectors = 0;
 
     return instance;
 }
@@ -175,10 +190,34 @@ void UsbMassStorage_free(void* ptr) {
         usb_scsi_free(instance->scsi);
     }
 
+    if(instance->overlay != NULL) {
+        block_device_free(instance->overlay);
+    }
+
+    if(instance->cache_device != NULL) {
+        block_device_free(instance->cache_device);
+    }
+
+    if(instance->cache != NULL) {
+        sector_cache_free(instance->cache);
+    }
+
+    if(instance->prefetcher != NULL) {
+        block_device_free(instance->prefetcher);
+    }
+
+    if(instance->device != NULL) {
+        block_device_free(instance->device);
+    }
+
     if(instance->vfat != NULL) {
         virtual_fat_free(instance->vfat);
     }
 
+    if(instance->raw_image != NULL) {
+        raw_image_free(instance->raw_image);
+    }
+
     furi_string_free(instance->ip_addr);
     furi_string_free(instance->subnet_mask);
     furi_string_free(instance->gateway);
@@ -187,6 +226,7 @@ void UsbMassStorage_free(void* ptr) {
     furi_string_free(instance->network_interface);
     furi_string_free(instance->status_text);
     furi_string_free(instance->current_file);
+    furi_string_free(instance->image_path);
 
     view_free(instance->view);
 
@@ -214,7 +254,11 @@ void UsbMassStorage_set_config(
     const char* chainload_url,
     const char* network_interface,
     PartitionScheme partition_scheme,
-    bool chainload_enabled) {
+    bool chainload_enabled,
+    uint8_t sectors_per_cluster,
+    uint32_t min_disk_size_mb,
+    const char* image_path,
+    uint16_t write_overlay_sectors) {
     instance->dhcp = dhcp;
     furi_string_set_str(instance->ip_addr, ip_addr);
     furi_string_set_str(instance->subnet_mask, subnet_mask);
@@ -224,6 +268,69 @@ void UsbMassStorage_set_config(
     furi_string_set_str(instance->network_interface, network_interface);
     instance->partition_scheme = partition_scheme;
     instance->chainload_enabled = chainload_enabled;
+    instance->sectors_per_cluster = sectors_per_cluster;
+    instance->min_disk_size_mb = min_disk_size_mb;
+    furi_string_set_str(instance->image_path, image_path);
+    instance->write_overlay_sectors = write_overlay_sectors;
+}
+
+// Firmware re-reads PE headers and the certificate table at the end of EFI
+// binaries while loading and verifying them, keep both ends cached
+static void usb_mass_storage_pin_efi(
+    const VirtualFatFile* file,
+    uint32_t lba,
+    uint32_t sectors,
+    void* context) {
+    SectorCache* cache = context;
+    if(memcmp(file->name + 8, "EFI", 3) != 0) return;
+
+    uint32_t head = MIN(sectors, (uint32_t)EFI_PIN_SECTORS);
+    sector_cache_pin(cache, lba, head);
+
+    uint32_t tail = MIN(sectors - head, (uint32_t)EFI_PIN_SECTORS);
+    if(tail > 0) sector_cache_pin(cache, lba + sectors - tail, tail);
+}
+
+// Serve instance->device over USB MSC, behind the prefetcher, the sector cache
+// and a write overlay if enabled
+// Closes the storage record opened by the OK handler
+static void usb_mass_storage_start_msc(App* app, AppUsbMassStorage* instance) {
+    // SD reads overlap with USB transfers, the backend is only touched by the prefetcher
+    instance->prefetcher = prefetcher_alloc(instance->device);
+    BlockDevice* device = instance->prefetcher ? instance->prefetcher : instance->device;
+
+    // Blocks the host reads again are served from RAM, sized from the heap left now
+    instance->cache = sector_cache_alloc(device, sector_cache_budget(SECTOR_SIZE));
+    if(instance->cache) {
+        if(instance->vfat) {
+            virtual_fat_for_each_file_range(
+                instance->vfat, usb_mass_storage_pin_efi, instance->cache);
+        }
+        instance->cache_device = sector_cache_block_device_alloc(instance->cache);
+        device = instance->cache_device;
+    }
+
+    // Host writes (FSInfo, dirty bits) land in RAM, the backend stays untouched
+    if(instance->write_overlay_sectors > 0) {
+        instance->overlay = cow_overlay_alloc(device, instance->write_overlay_sectors);
+    }
+
+    instance->scsi = usb_scsi_alloc();
+    usb_scsi_set_block_device(instance->scsi, instance->overlay ? instance->overlay : device);
+
+    instance->msc = usb_msc_alloc();
+    usb_msc_set_scsi(instance->msc, instance->scsi);
+
+    if(!usb_msc_start(instance->msc)) {
+        furi_string_set(instance->status_text, "Failed to start USB MSC");
+        instance->state = UsbMassStorageStateError;
+    } else {
+        // Success!
+        instance->state = UsbMassStorageStateActive;
+    }
+
+    furi_record_close(RECORD_STORAGE);
+    view_dispatcher_switch_to_view(app->view_dispatcher, THIS_SCENE);
 }
 
 void UsbMassStorage_on_enter(void* context) {
@@ -250,8 +357,28 @@ bool UsbMassStorage_on_event(void* context, SceneManagerEvent event) {
             instance->state = UsbMassStorageStateStarting;
             view_dispatcher_switch_to_view(app->view_dispatcher, THIS_SCENE);
 
-            // 1. Validate iPXE binaries
             Storage* storage = furi_record_open(RECORD_STORAGE);
+
+            // Raw image mode serves a prebuilt disk image as is, no iPXE files needed
+            if(furi_string_size(instance->image_path) > 0) {
+                instance->raw_image = raw_image_alloc();
+                if(!raw_image_open(
+                       instance->raw_image, storage, furi_string_get_cstr(instance->image_path))) {
+                    furi_string_set(instance->status_text, "Cannot open disk image");
+                    raw_image_free(instance->raw_image);
+                    instance->raw_image = NULL;
+                    instance->state = UsbMassStorageStateError;
+                    furi_record_close(RECORD_STORAGE);
+                    view_dispatcher_switch_to_view(app->view_dispatcher, THIS_SCENE);
+                    return true;
+                }
+
+                instance->device = raw_image_block_device_alloc(instance->raw_image);
+                usb_mass_storage_start_msc(app, instance);
+                return true;
+            }
+
+            // 1. Validate iPXE binaries
             IpxeValidationResult validation;
 
             if(!ipxe_validate_binaries(storage, &validation)) {
@@ -296,6 +423,13 @@ bool UsbMassStorage_on_event(void* context, SceneManagerEvent event) {
             // Set partition scheme from config
             virtual_fat_set_partition_scheme(instance->vfat, instance->partition_scheme);
 
+            // Set cluster size from config (0 = automatic)
+            virtual_fat_set_sectors_per_cluster(instance->vfat, instance->sectors_per_cluster);
+
+            // Set minimum disk size from config (0 = partition scheme default)
+            virtual_fat_set_min_total_sectors(
+                instance->vfat, instance->min_disk_size_mb * (1024 * 1024 / SECTOR_SIZE));
+
             // Register file read callback
             virtual_fat_set_read_callback(instance->vfat, file_read_callback, instance);
 
@@ -350,29 +484,34 @@ bool UsbMassStorage_on_event(void* context, SceneManagerEvent event) {
                 return true;
             }
 
-            // 4. Initialize SCSI context
-            instance->scsi = usb_scsi_alloc();
-            usb_scsi_set_storage(instance->scsi, storage);
-            usb_scsi_set_virtual_fat(instance->scsi, instance->vfat);
-
-            // 5. Initialize and start USB MSC
-            instance->msc = usb_msc_alloc();
-            usb_msc_set_scsi(instance->msc, instance->scsi);
-
-            if(!usb_msc_start(instance->msc)) {
-                furi_string_set(instance->status_text, "Failed to start USB MSC");
+            // Mirror the payload directory after the iPXE files, so those keep their names
+            if(storage_dir_exists(storage, PAYLOAD_DIR_PATH) &&
+               !virtual_fat_add_sd_tree(storage, instance->vfat, PAYLOAD_DIR_PATH, "")) {
+                furi_string_set(instance->status_text, "Failed to add payload");
+                virtual_fat_free(instance->vfat);
+                instance->vfat = NULL;
                 instance->state = UsbMassStorageStateError;
                 furi_record_close(RECORD_STORAGE);
                 view_dispatcher_switch_to_view(app->view_dispatcher, THIS_SCENE);
                 return true;
             }
 
-            furi_record_close(RECORD_STORAGE);
+            // All files registered, assign clusters and build the sector lookup index
+            if(!virtual_fat_seal(instance->vfat)) {
+                furi_string_set(instance->status_text, "Files do not fit the disk");
+                virtual_fat_free(instance->vfat);
+                instance->vfat = NULL;
+                instance->state = UsbMassStorageStateError;
+                furi_record_close(RECORD_STORAGE);
+                view_dispatcher_switch_to_view(app->view_dispatcher, THIS_SCENE);
+                return true;
+            }
 
-            // Success!
-            instance->state = UsbMassStorageStateActive;
-            view_dispatcher_switch_to_view(app->view_dispatcher, THIS_SCENE);
+            // 4. Initialize block device
+            instance->device = virtual_fat_block_device_alloc(instance->vfat, storage);
 
+            // 5. Initialize SCSI context and start USB MSC
+            usb_mass_storage_start_msc(app, instance);
             return true;
         }
     } else if(event.type == SceneManagerEventTypeBack) {
@@ -392,11 +531,41 @@ bool UsbMassStorage_on_event(void* context, SceneManagerEvent event) {
                 instance->scsi = NULL;
             }
 
+            if(instance->overlay) {
+                block_device_free(instance->overlay);
+                instance->overlay = NULL;
+            }
+
+            if(instance->cache_device) {
+                block_device_free(instance->cache_device);
+                instance->cache_device = NULL;
+            }
+
+            if(instance->cache) {
+                sector_cache_free(instance->cache);
+                instance->cache = NULL;
+            }
+
+            if(instance->prefetcher) {
+                block_device_free(instance->prefetcher);
+                instance->prefetcher = NULL;
+            }
+
+            if(instance->device) {
+                block_device_free(instance->device);
+                instance->device = NULL;
+            }
+
             if(instance->vfat) {
                 virtual_fat_free(instance->vfat);
                 instance->vfat = NULL;
             }
 
+            if(instance->raw_image) {
+                raw_image_free(instance->raw_image);
+                instance->raw_image = NULL;
+            }
+
             instance->state = UsbMassStorageStateIdle;
             return false; // Allow back navigation
         }
@@ -5,6 +5,10 @@
 #include <gui/view_dispatcher.h>
 #include <gui/modules/widget.h>
 #include "../../disk/virtual_fat.h"
+#include "../../disk/raw_image.h"
+#include "../../disk/cow_overlay.h"
+#include "../../disk/prefetcher.h"
+#include "../../disk/sector_cache.h"
 #include "../../usb/usb_scsi.h"
 #include "../../usb/usb_msc.h"
 
@@ -33,11 +37,21 @@ typedef struct {
     FuriString* network_interface;
     PartitionScheme partition_scheme;
     bool chainload_enabled;
+    uint8_t sectors_per_cluster;
+    uint32_t min_disk_size_mb;
+    FuriString* image_path; // Raw disk image, empty for the virtual FAT
+    uint16_t write_overlay_sectors; // 0 = read-only medium
 
     FuriThread* usb_thread;
     FuriString* status_text;
     FuriString* current_file;
     VirtualFat* vfat;
+    RawImage* raw_image;
+    BlockDevice* device; // Backend served over USB, wraps vfat or raw_image
+    BlockDevice* prefetcher; // Read-ahead on top of device
+    SectorCache* cache; // LRU cache on top of prefetcher, NULL if the heap is short
+    BlockDevice* cache_device; // Serves cache
+    BlockDevice* overlay; // RAM write overlay on top of the cache, NULL if read-only
     UsbScsiContext* scsi;
     UsbMscContext* msc;
 } AppUsbMassStorage;
@@ -60,4 +74,8 @@ void UsbMassStorage_set_config(
     const char* chainload_url,
     const char* network_interface,
     PartitionScheme partition_scheme,
-    bool chainload_enabled);
+    bool chainload_enabled,
+    uint8_t sectors_per_cluster,
+    uint32_t min_disk_size_mb,
+    const char* image_path,
+    uint16_t write_overlay_sectors);
@@ -13,29 +13,40 @@ typedef enum {
     EventRxTx = (1 << 2),
 } WorkerEventFlag;
 
-typedef enum {
-    MSC_STATE_IDLE,
-    MSC_STATE_READ_CBW,
-    MSC_STATE_DATA_IN,
-    MSC_STATE_DATA_OUT,
-    MSC_STATE_BUILD_CSW,
-    MSC_STATE_WRITE_CSW,
-} MscState;
+// TX events merge into a pending one, so a few slots cover the endpoint buffers (2 IN, 1 OUT)
+#define USB_MSC_EVENT_QUEUE_SIZE 8 // Power of two
+#define USB_MSC_EVENT_QUEUE_MASK (USB_MSC_EVENT_QUEUE_SIZE - 1)
+
+// Longer CSW to CBW gaps are the host idling between command sequences, not turnaround
+#define USB_MSC_TURNAROUND_IDLE_US 2000
+
+typedef struct {
+    uint8_t event; // usbd_evt_eprx or usbd_evt_eptx
+    uint8_t ep; // Endpoint address the event came from
+} UsbMscEvent;
 
 struct UsbMscContext {
     UsbScsiContext* scsi;
     usbd_device* usb_dev;
 
-    MscState state;
+    // BOT command flow (see usb_msc_bot_run)
+    uint16_t bot_resume; // Resume point, 0 = start of the flow
+    uint8_t bot_wait; // Endpoint event the flow is waiting for
     UsbMscCbw cbw;
     UsbMscCsw csw;
-
-    uint8_t tx_buffer[512];
-    uint32_t tx_len; // Length of data in tx_buffer (0 = buffer empty)
+    uint32_t device_in; // Data IN bytes the command intended to send (Di)
+    uint32_t device_out; // Data OUT bytes the command intended to receive (Do)
+    uint32_t in_queued; // IN packets handed to the endpoint, worker only
+    uint32_t in_completed; // IN packets sent, USB interrupt only
+    bool reset_recovery; // Invalid CBW seen, halts are kept until a BOT reset
+    bool reset_pending; // Reset requested, IN writes are refused until the worker restarts
+    uint32_t csw_cycles; // DWT cycle count when the last CSW was queued
+    bool csw_pending_cbw; // A CSW went out and the next CBW has not arrived yet
+
+    // Data phase packets go straight between the endpoint and the SCSI staging buffer
     uint32_t tx_offset; // Total bytes sent so far
-
-    uint8_t rx_buffer[512];
-    uint32_t rx_len;
+    uint32_t rx_len; // Total bytes received so far
+    uint32_t rx_discarded; // Data OUT bytes read and dropped, not used by the command
 
     bool active;
 
@@ -43,8 +54,17 @@ struct UsbMscContext {
     FuriThread* thread;
     FuriThreadId thread_id;
 
+    // Endpoint events, single producer (USB interrupt) and single consumer (worker)
+    UsbMscEvent events[USB_MSC_EVENT_QUEUE_SIZE];
+    uint32_t event_head; // Written by the producer only
+    uint32_t event_tail; // Written by the consumer only
+    uint32_t reset_head; // event_head when the last BOT reset request arrived
+    uint32_t overflows_seen; // stats.event_overflows already handled by the worker
+
     // Previous USB mode for restoration
     FuriHalUsbInterface* prev_usb_mode;
+
+    UsbMscStats stats;
 };
 
 // USB MSC class-specific requests
@@ -142,7 +162,6 @@ UsbMscContext* usb_msc_alloc(void) {
 
     ctx->scsi = NULL;
     ctx->usb_dev = NULL;
-    ctx->state = MSC_STATE_IDLE;
     ctx->active = false;
     ctx->prev_usb_mode = NULL;
 
@@ -168,11 +187,62 @@ bool usb_msc_set_scsi(UsbMscContext* ctx, UsbScsiContext* scsi) {
     return true;
 }
 
+// Queue an endpoint event for the worker, called from the USB interrupt only
+static void usb_msc_event_push(UsbMscContext* ctx, uint8_t event, uint8_t ep) {
+    uint32_t head = ctx->event_head;
+    uint32_t tail = __atomic_load_n(&ctx->event_tail, __ATOMIC_ACQUIRE);
+    UsbMscEvent* last = &ctx->events[(head - 1) & USB_MSC_EVENT_QUEUE_MASK];
+    if(event == usbd_evt_eptx && head != tail && last->event == event && last->ep == ep) {
+        // Not handled yet, one TX event already makes the worker refill the free buffers
+    } else if(head - tail < USB_MSC_EVENT_QUEUE_SIZE) {
+        ctx->events[head & USB_MSC_EVENT_QUEUE_MASK].event = event;
+        ctx->events[head & USB_MSC_EVENT_QUEUE_MASK].ep = ep;
+        __atomic_store_n(&ctx->event_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        ctx->stats.event_overflows++;
+    }
+
+    // Signal worker thread to process event
+    furi_thread_flags_set(ctx->thread_id, EventRxTx);
+}
+
+// Restart the worker's command flow, called from the USB interrupt only
+static void usb_msc_request_reset(UsbMscContext* ctx) {
+    if(ctx == NULL || ctx->thread_id == NULL) return;
+
+    // IN writes of the aborted command are refused until the worker restarts
+    __atomic_store_n(&ctx->reset_pending, true, __ATOMIC_RELAXED);
+
+    // Events queued before the reset belong to the aborted command
+    __atomic_store_n(&ctx->reset_head, ctx->event_head, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->reset_recovery, false, __ATOMIC_RELAXED);
+    furi_thread_flags_set(ctx->thread_id, EventReset);
+}
+
 static usbd_respond
     usb_msc_control(usbd_device* dev, usbd_ctlreq* req, usbd_rqc_callback* callback) {
-    UNUSED(dev);
     UNUSED(callback);
 
+    UsbMscContext* ctx = g_msc_ctx;
+
+    // CLEAR_FEATURE(ENDPOINT_HALT) on a data endpoint, the host is done with a halted data phase
+    if((req->bmRequestType & (USB_REQ_TYPE | USB_REQ_RECIPIENT)) ==
+           (USB_REQ_STANDARD | USB_REQ_ENDPOINT) &&
+       req->bRequest == USB_STD_CLEAR_FEATURE && req->wValue == USB_FEAT_ENDPOINT_HALT &&
+       (req->wIndex == USB_MSC_EP_IN || req->wIndex == USB_MSC_EP_OUT)) {
+        // After an invalid CBW both endpoints stay halted until a BOT reset
+        if(ctx && __atomic_load_n(&ctx->reset_recovery, __ATOMIC_RELAXED)) return usbd_ack;
+
+        // Also empties both buffers of the double buffered IN endpoint and resets its toggle
+        usbd_ep_unstall(dev, req->wIndex);
+
+        // A CSW held back by the halted IN endpoint can go out now
+        if(ctx && ctx->thread_id != NULL && req->wIndex == USB_MSC_EP_IN) {
+            usb_msc_event_push(ctx, usbd_evt_eptx, USB_MSC_EP_IN);
+        }
+        return usbd_ack;
+    }
+
     if((req->bmRequestType & (USB_REQ_TYPE | USB_REQ_RECIPIENT)) ==
        (USB_REQ_CLASS | USB_REQ_INTERFACE)) {
         switch(req->bRequest) {
@@ -182,10 +252,11 @@ static usbd_respond
             return usbd_ack;
 
         case USB_MSC_BOT_RESET:
-            // Reset MSC state
-            if(g_msc_ctx && g_msc_ctx->thread_id != NULL) {
-                furi_thread_flags_set(g_msc_ctx->thread_id, EventReset);
-            }
+            // Reset MSC state, the host clears the endpoint halts next
+            // Halts and data toggles are kept (BOT 5.3.4). IN packets of the aborted command
+            // stay queued until the CLEAR_FEATURE(ENDPOINT_HALT) of reset recovery drops them.
+            if(req->wValue != 0 || req->wLength != 0) return usbd_fail;
+            usb_msc_request_reset(ctx);
             return usbd_ack;
 
         default:
@@ -206,278 +277,430 @@ static usbd_respond usb_msc_config(usbd_device* dev, uint8_t cfg) {
         return usbd_ack;
     }
 
-    // Configure endpoints
-    usbd_ep_config(dev, USB_MSC_EP_IN, USB_EPTYPE_BULK, USB_MSC_EP_SIZE);
+    // Configure endpoints, IN is double buffered so a packet is queued while another is sent
+    usbd_ep_config(dev, USB_MSC_EP_IN, USB_EPTYPE_BULK | USB_EPTYPE_DBLBUF, USB_MSC_EP_SIZE);
     usbd_ep_config(dev, USB_MSC_EP_OUT, USB_EPTYPE_BULK, USB_MSC_EP_SIZE);
     usbd_reg_endpoint(dev, USB_MSC_EP_IN, usb_msc_ep_callback);
     usbd_reg_endpoint(dev, USB_MSC_EP_OUT, usb_msc_ep_callback);
 
+    // Fresh endpoints, a command cut off by a bus reset is dropped
+    usb_msc_request_reset(g_msc_ctx);
+
     return usbd_ack;
 }
 
-// Endpoint callbacks - only signal thread flags
+// Endpoint callbacks - queue the event and signal the worker thread
 static void usb_msc_ep_callback(usbd_device* dev, uint8_t event, uint8_t ep) {
     UNUSED(dev);
-    UNUSED(event);
-    UNUSED(ep);
 
     UsbMscContext* ctx = g_msc_ctx;
     if(ctx == NULL || ctx->thread_id == NULL) return;
 
-    // Signal worker thread to process event
-    furi_thread_flags_set(ctx->thread_id, EventRxTx);
+    // Counted before merging, the worker compares it with the packets it queued
+    if(event == usbd_evt_eptx) {
+        __atomic_store_n(&ctx->in_completed, ctx->in_completed + 1, __ATOMIC_RELEASE);
+    }
+
+    usb_msc_event_push(ctx, event, ep);
 }
 
-// Worker thread function - processes USB MSC state machine
-static int32_t mass_thread_worker(void* context) {
-    UsbMscContext* ctx = (UsbMscContext*)context;
+// Take the oldest queued endpoint event, worker thread only
+// Stops at a pending reset: events queued after it belong to the restarted flow
+static bool usb_msc_event_pop(UsbMscContext* ctx, UsbMscEvent* event) {
+    uint32_t tail = ctx->event_tail;
+    uint32_t head = __atomic_load_n(&ctx->event_head, __ATOMIC_ACQUIRE);
 
-    FURI_LOG_I(TAG, "Worker thread started");
+    // head is read first, a reset flagged after this check was queued behind it
+    if(furi_thread_flags_get() & EventReset) {
+        uint32_t reset_head = __atomic_load_n(&ctx->reset_head, __ATOMIC_RELAXED);
+        if((int32_t)(head - reset_head) > 0) head = reset_head;
+    }
+    if(tail == head) return false;
 
-    // Store thread ID for callbacks
-    ctx->thread_id = furi_thread_get_current_id();
-    ctx->state = MSC_STATE_READ_CBW;
+    *event = ctx->events[tail & USB_MSC_EVENT_QUEUE_MASK];
+    __atomic_store_n(&ctx->event_tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
 
-    while(1) {
-        uint32_t flags = furi_thread_flags_wait(
-            EventExit | EventReset | EventRxTx, FuriFlagWaitAny, FuriWaitForever);
+// BOT protothread: the command flow is written top to bottom and parks at each wait.
+// bot_resume holds the line to resume at, so locals do not survive a wait (keep state in ctx).
+// A wait always yields first and resumes only on the awaited endpoint event.
+#define BOT_BEGIN(ctx)          \
+    switch((ctx)->bot_resume) { \
+    case 0:
+#define BOT_WAIT_EVENT(ctx, ev)          \
+    do {                                 \
+        (ctx)->bot_wait = (ev);          \
+        (ctx)->bot_resume = __LINE__;    \
+        return;                          \
+    case __LINE__:                       \
+        if(event != (ev)) return;        \
+    } while(0)
+#define BOT_END(ctx) \
+    }                \
+    (ctx)->bot_resume = 0
+
+// Read and validate the CBW of the packet that just arrived
+static bool usb_msc_read_cbw(UsbMscContext* ctx, usbd_device* dev) {
+    int32_t len = usbd_ep_read(dev, USB_MSC_EP_OUT, &ctx->cbw, sizeof(UsbMscCbw));
+
+    if(len <= 0) {
+        // Zero length packet, wait for next RX event
+        return false;
+    }
 
-        // Check for exit
-        if(flags & EventExit) {
-            FURI_LOG_I(TAG, "Worker thread exiting");
-            break;
-        }
+    // Not valid or not meaningful: halt both endpoints until the host's reset recovery
+    if(len != sizeof(UsbMscCbw) || ctx->cbw.dSignature != USB_MSC_CBW_SIGNATURE ||
+       ctx->cbw.bLUN != 0 || ctx->cbw.bCBLength == 0 ||
+       ctx->cbw.bCBLength > sizeof(ctx->cbw.CB)) {
+        FURI_LOG_E(TAG, "Invalid CBW: len=%ld, sig=0x%08lX", len, ctx->cbw.dSignature);
+        __atomic_store_n(&ctx->reset_recovery, true, __ATOMIC_RELAXED);
+        usbd_ep_stall(dev, USB_MSC_EP_IN);
+        usbd_ep_stall(dev, USB_MSC_EP_OUT);
+        return false;
+    }
 
-        // Check for reset
-        if(flags & EventReset) {
-            FURI_LOG_D(TAG, "Reset event");
-            ctx->state = MSC_STATE_READ_CBW;
-            ctx->tx_offset = 0;
-            ctx->tx_len = 0;
-            continue;
+    FURI_LOG_D(
+        TAG,
+        "CBW: cmd=0x%02X, datalen=%lu, flags=0x%02X, tag=%lu",
+        ctx->cbw.CB[0],
+        ctx->cbw.dDataLength,
+        ctx->cbw.bmFlags,
+        ctx->cbw.dTag);
+
+    return true;
+}
+
+// Time from the previous CSW to this CBW, host turnaround plus worker latency
+// Only gaps inside a busy command sequence are measured, idle time is counted apart
+static void usb_msc_count_turnaround(UsbMscContext* ctx) {
+    if(!ctx->csw_pending_cbw) return;
+    ctx->csw_pending_cbw = false;
+
+    uint32_t us = (DWT->CYCCNT - ctx->csw_cycles) / furi_hal_cortex_instructions_per_microsecond();
+    if(us > USB_MSC_TURNAROUND_IDLE_US) {
+        ctx->stats.idle_gaps++;
+        return;
+    }
+    ctx->stats.turnarounds++;
+    ctx->stats.turnaround_us_total += us;
+    if(us > ctx->stats.turnaround_us_max) ctx->stats.turnaround_us_max = us;
+}
+
+// Hand a packet to the IN endpoint, counted so the worker knows when the buffers drained
+static bool usb_msc_in_write(
+    UsbMscContext* ctx,
+    usbd_device* dev,
+    const void* data,
+    uint16_t len) {
+    // Checked with the interrupt masked, so nothing is queued behind a BOT reset flush
+    bool written = false;
+    FURI_CRITICAL_ENTER();
+    if(!__atomic_load_n(&ctx->reset_pending, __ATOMIC_RELAXED)) {
+        written = usbd_ep_write(dev, USB_MSC_EP_IN, data, len) >= 0;
+    }
+    FURI_CRITICAL_EXIT();
+
+    if(written) ctx->in_queued++;
+    return written;
+}
+
+// All packets handed to the IN endpoint have been sent
+static bool usb_msc_in_idle(UsbMscContext* ctx) {
+    return ctx->in_queued == __atomic_load_n(&ctx->in_completed, __ATOMIC_ACQUIRE);
+}
+
+// Answer a polled command from the response table, its CSW can follow right away
+// false if the command must go through usb_scsi_process_command
+static bool usb_msc_fast_command(UsbMscContext* ctx, usbd_device* dev) {
+    // Data OUT commands take the regular path
+    if(ctx->cbw.dDataLength > 0 && !(ctx->cbw.bmFlags & USB_MSC_CBW_FLAG_IN)) return false;
+
+    const uint8_t* data;
+    size_t len;
+    if(!usb_scsi_fast_command(
+           ctx->scsi, ctx->cbw.CB, ctx->cbw.bCBLength, ctx->cbw.dDataLength, &data, &len)) {
+        return false;
+    }
+
+    // Responses fit in one packet, the host read the previous CSW so the buffers are free.
+    // If not, the response stays staged in usb_scsi and goes out as regular data IN.
+    if(len > 0) {
+        if(!usb_msc_in_write(ctx, dev, data, len)) return true;
+        usb_scsi_tx_consume(ctx->scsi, len);
+        ctx->tx_offset = len;
+    }
+    ctx->stats.fast_commands++;
+    return true;
+}
+
+// Queue data IN packets until the endpoint buffers are full, false if the device read failed
+static bool usb_msc_data_in_burst(UsbMscContext* ctx, usbd_device* dev) {
+    // Each TX complete event then refills the buffer that was just sent
+    ctx->stats.data_in_wakeups++;
+    while(usb_scsi_has_tx_data(ctx->scsi) && ctx->tx_offset < ctx->cbw.dDataLength) {
+        // Next packet comes straight from the SCSI staging buffer
+        const uint8_t* tx_data;
+        size_t tx_len = usb_scsi_tx_peek(ctx->scsi, &tx_data);
+        if(tx_len == 0) {
+            // SCSI said it has data but returned 0 bytes (device read failed)
+            FURI_LOG_E(TAG, "SCSI TX failed despite has_tx_data=true");
+            return false;
         }
 
-        // Process RX/TX event
-        if(flags & EventRxTx) {
-            usbd_device* dev = ctx->usb_dev;
-            if(dev == NULL) continue;
+        // Never more than the host asked for (case 7 sends dDataLength bytes)
+        if(tx_len > USB_MSC_EP_SIZE) tx_len = USB_MSC_EP_SIZE;
+        if(tx_len > ctx->cbw.dDataLength - ctx->tx_offset) {
+            tx_len = ctx->cbw.dDataLength - ctx->tx_offset;
+        }
 
-            switch(ctx->state) {
-            case MSC_STATE_READ_CBW: {
-                // Read Command Block Wrapper from host
-                int32_t len = usbd_ep_read(dev, USB_MSC_EP_OUT, &ctx->cbw, sizeof(UsbMscCbw));
+        // usbd_ep_write copies into packet memory, the staging bytes are free after it
+        if(!usb_msc_in_write(ctx, dev, tx_data, tx_len)) {
+            // Endpoint full - nothing consumed, continue on the next TX complete event
+            break;
+        }
 
-                if(len <= 0) {
-                    // No data available yet, wait for next RX event
-                    break;
-                }
+        usb_scsi_tx_consume(ctx->scsi, tx_len);
+        ctx->tx_offset += tx_len;
+        ctx->stats.data_in_packets++;
+        ctx->stats.data_in_bytes += tx_len;
+    }
+    return true;
+}
 
-                if(len != sizeof(UsbMscCbw) || ctx->cbw.dSignature != USB_MSC_CBW_SIGNATURE) {
-                    FURI_LOG_E(TAG, "Invalid CBW: len=%ld, sig=0x%08lX", len, ctx->cbw.dSignature);
-                    usbd_ep_stall(dev, USB_MSC_EP_IN);
-                    usbd_ep_stall(dev, USB_MSC_EP_OUT);
-                    ctx->state = MSC_STATE_READ_CBW;
-                    break;
-                }
+// Receive one data OUT packet straight into the SCSI staging buffer, false if it failed
+static bool usb_msc_data_out_packet(UsbMscContext* ctx, usbd_device* dev) {
+    uint8_t* rx_space;
+    size_t rx_space_len = usb_scsi_rx_peek(ctx->scsi, &rx_space);
+    if(rx_space_len > USB_MSC_EP_SIZE) rx_space_len = USB_MSC_EP_SIZE;
 
-                FURI_LOG_D(
-                    TAG,
-                    "CBW: cmd=0x%02X, datalen=%lu, flags=0x%02X, tag=%lu",
-                    ctx->cbw.CB[0],
-                    ctx->cbw.dDataLength,
-                    ctx->cbw.bmFlags,
-                    ctx->cbw.dTag);
+    int32_t len = usbd_ep_read(dev, USB_MSC_EP_OUT, rx_space, rx_space_len);
+    if(len <= 0) return true;
 
-                // Process SCSI command
-                bool cmd_ok = usb_scsi_process_command(ctx->scsi, ctx->cbw.CB, ctx->cbw.bCBLength);
+    // usbd_ep_read returns the packet length, a longer packet was truncated
+    if((size_t)len > rx_space_len || !usb_scsi_rx_commit(ctx->scsi, len)) {
+        ctx->rx_discarded += len;
+        return false;
+    }
+    ctx->rx_len += len;
+    return true;
+}
 
-                if(!cmd_ok) {
-                    FURI_LOG_W(TAG, "SCSI command failed");
-                    ctx->csw.bStatus = USB_MSC_CSW_STATUS_FAILED;
+// Read and drop one data OUT packet the command does not use
+static void usb_msc_data_out_discard(UsbMscContext* ctx, usbd_device* dev) {
+    int32_t len = usbd_ep_read(dev, USB_MSC_EP_OUT, NULL, 0);
+    if(len > 0) ctx->rx_discarded += len;
+}
 
-                    // Send CSW immediately for failed commands
-                    ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
-                    ctx->csw.dTag = ctx->cbw.dTag;
-                    ctx->csw.dDataResidue = ctx->cbw.dDataLength;
+// Bytes moved in the data phase of the current command
+static uint32_t usb_msc_transferred(UsbMscContext* ctx) {
+    return (ctx->cbw.bmFlags & USB_MSC_CBW_FLAG_IN) ? ctx->tx_offset : ctx->rx_len;
+}
 
-                    usbd_ep_write(dev, USB_MSC_EP_IN, &ctx->csw, sizeof(UsbMscCsw));
-                    FURI_LOG_D(TAG, "CSW sent (failed): status=%u", ctx->csw.bStatus);
+// Fill the CSW for the finished command, bStatus is already set
+static void usb_msc_build_csw(UsbMscContext* ctx) {
+    uint32_t transferred = usb_msc_transferred(ctx);
+    ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
+    ctx->csw.dTag = ctx->cbw.dTag;
+    ctx->csw.dDataResidue =
+        (ctx->cbw.dDataLength > transferred) ? (ctx->cbw.dDataLength - transferred) : 0;
+
+    if(ctx->csw.bStatus == USB_MSC_CSW_STATUS_PHASE_ERROR) {
+        ctx->stats.phase_errors++;
+        FURI_LOG_W(
+            TAG,
+            "Phase error: cmd=0x%02X, host=%lu %s, device in=%lu out=%lu",
+            ctx->cbw.CB[0],
+            ctx->cbw.dDataLength,
+            (ctx->cbw.bmFlags & USB_MSC_CBW_FLAG_IN) ? "in" : "out",
+            ctx->device_in,
+            ctx->device_out);
+    } else if(ctx->csw.dDataResidue > 0 && ctx->csw.bStatus == USB_MSC_CSW_STATUS_PASSED) {
+        FURI_LOG_W(
+            TAG,
+            "Data residue: expected=%lu, transferred=%lu, residue=%lu",
+            ctx->cbw.dDataLength,
+            transferred,
+            ctx->csw.dDataResidue);
+    }
+}
 
-                    ctx->state = MSC_STATE_READ_CBW;
-                    break;
-                }
+// Run the BOT command flow on an endpoint event (usbd_evt_eprx or usbd_evt_eptx)
+// Host (H) and device (D) data phases follow the 13 cases of the BOT spec, section 6.7:
+// the device moves at most min(H, D) bytes, halts IN or drops excess OUT data so the host
+// can finish its data phase, and reports a phase error when directions or lengths mismatch.
+static void usb_msc_bot_run(UsbMscContext* ctx, usbd_device* dev, uint8_t event) {
+    BOT_BEGIN(ctx);
+    while(true) {
+        // Command transport: parked here while the previous CSW is still in flight
+        BOT_WAIT_EVENT(ctx, usbd_evt_eprx);
+        if(!usb_msc_read_cbw(ctx, dev)) continue;
+        usb_msc_count_turnaround(ctx);
+
+        ctx->tx_offset = 0;
+        ctx->rx_len = 0;
+        ctx->rx_discarded = 0;
+        ctx->device_in = 0;
+        ctx->device_out = 0;
+        ctx->csw.bStatus = USB_MSC_CSW_STATUS_PASSED;
+
+        // Polled commands are answered from the response table, anything else is processed
+        if(!usb_msc_fast_command(ctx, dev) &&
+           !usb_scsi_process_command(ctx->scsi, ctx->cbw.CB, ctx->cbw.bCBLength)) {
+            FURI_LOG_W(TAG, "SCSI command failed");
+            ctx->csw.bStatus = USB_MSC_CSW_STATUS_FAILED;
+        }
+        ctx->device_in = ctx->tx_offset + usb_scsi_tx_length(ctx->scsi);
+        ctx->device_out = usb_scsi_rx_length(ctx->scsi);
 
-                // Determine next state based on data direction
-                if(ctx->cbw.dDataLength > 0) {
-                    if(ctx->cbw.bmFlags & 0x80) {
-                        // Data IN (device to host)
-                        FURI_LOG_D(TAG, "Transitioning to DATA_IN state, fall through");
-                        ctx->state = MSC_STATE_DATA_IN;
-                        ctx->tx_offset = 0;
-                        // Fall through to DATA_IN case immediately
-                        goto process_data_in;
-                    } else {
-                        // Data OUT (host to device)
-                        ctx->state = MSC_STATE_DATA_OUT;
-                        ctx->rx_len = 0;
-                        // Break and wait for data from host
+        if(ctx->cbw.dDataLength == 0) {
+            // Cases 1 to 3: Hn
+            if(ctx->device_in > 0 || ctx->device_out > 0) {
+                ctx->csw.bStatus = USB_MSC_CSW_STATUS_PHASE_ERROR;
+            }
+        } else if(ctx->cbw.bmFlags & USB_MSC_CBW_FLAG_IN) {
+            // Cases 4 to 8: Hi
+            if(ctx->device_out > 0) {
+                ctx->csw.bStatus = USB_MSC_CSW_STATUS_PHASE_ERROR;
+            } else {
+                while(true) {
+                    if(!usb_msc_data_in_burst(ctx, dev)) {
+                        ctx->csw.bStatus = USB_MSC_CSW_STATUS_FAILED;
                         break;
                     }
-                } else {
-                    // No data phase - send CSW immediately
-                    ctx->csw.bStatus = USB_MSC_CSW_STATUS_PASSED;
-                    ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
-                    ctx->csw.dTag = ctx->cbw.dTag;
-                    ctx->csw.dDataResidue = 0;
-
-                    usbd_ep_write(dev, USB_MSC_EP_IN, &ctx->csw, sizeof(UsbMscCsw));
-                    FURI_LOG_D(TAG, "CSW sent (no data): status=%u", ctx->csw.bStatus);
-
-                    ctx->state = MSC_STATE_READ_CBW;
-                    break;
-                }
-            }
-
-            case MSC_STATE_DATA_IN:
-            process_data_in: {
-                // Check if SCSI layer has more data to send
-                if(!usb_scsi_has_tx_data(ctx->scsi)) {
-                    // Data transfer complete
-                    FURI_LOG_D(TAG, "Data IN complete, total sent: %lu bytes", ctx->tx_offset);
-                    ctx->csw.bStatus = USB_MSC_CSW_STATUS_PASSED;
-
-                    // Prepare and send CSW
-                    ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
-                    ctx->csw.dTag = ctx->cbw.dTag;
-
-                    // Calculate residue: expected - actual
-                    uint32_t residue = (ctx->cbw.dDataLength > ctx->tx_offset) ?
-                                           (ctx->cbw.dDataLength - ctx->tx_offset) :
-                                           0;
-                    ctx->csw.dDataResidue = residue;
-
-                    if(residue > 0) {
-                        FURI_LOG_W(
-                            TAG,
-                            "Data residue: expected=%lu, sent=%lu, residue=%lu",
-                            ctx->cbw.dDataLength,
-                            ctx->tx_offset,
-                            residue);
+                    if(!usb_scsi_has_tx_data(ctx->scsi) ||
+                       ctx->tx_offset >= ctx->cbw.dDataLength) {
+                        break;
                     }
 
-                    usbd_ep_write(dev, USB_MSC_EP_IN, &ctx->csw, sizeof(UsbMscCsw));
-                    FURI_LOG_D(
-                        TAG,
-                        "CSW sent: status=%u, tag=%lu, residue=%lu",
-                        ctx->csw.bStatus,
-                        ctx->csw.dTag,
-                        ctx->csw.dDataResidue);
-
-                    ctx->state = MSC_STATE_READ_CBW;
-                    ctx->tx_offset = 0; // Reset for next command
-                    ctx->tx_len = 0;
-                    break;
+                    BOT_WAIT_EVENT(ctx, usbd_evt_eptx);
                 }
+                FURI_LOG_D(TAG, "Data IN complete, total sent: %lu bytes", ctx->tx_offset);
 
-                // If no data buffered, get new data from SCSI layer
-                if(ctx->tx_len == 0) {
-                    ctx->tx_len =
-                        usb_scsi_transmit_data(ctx->scsi, ctx->tx_buffer, USB_MSC_EP_SIZE);
-
-                    if(ctx->tx_len == 0) {
-                        // Unexpected: SCSI said it has data but returned 0 bytes
-                        FURI_LOG_E(TAG, "SCSI TX failed despite has_tx_data=true");
+                if(ctx->device_in > ctx->cbw.dDataLength) {
+                    ctx->csw.bStatus = USB_MSC_CSW_STATUS_PHASE_ERROR;
+                }
+            }
+        } else {
+            // Cases 9 to 13: Ho
+            if(ctx->device_in > 0) {
+                ctx->csw.bStatus = USB_MSC_CSW_STATUS_PHASE_ERROR;
+            } else {
+                while(ctx->rx_len < MIN(ctx->device_out, ctx->cbw.dDataLength)) {
+                    BOT_WAIT_EVENT(ctx, usbd_evt_eprx);
+                    if(!usb_msc_data_out_packet(ctx, dev)) {
                         ctx->csw.bStatus = USB_MSC_CSW_STATUS_FAILED;
-
-                        // Send error CSW
-                        ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
-                        ctx->csw.dTag = ctx->cbw.dTag;
-
-                        // Calculate residue: expected - actual
-                        uint32_t residue = (ctx->cbw.dDataLength > ctx->tx_offset) ?
-                                               (ctx->cbw.dDataLength - ctx->tx_offset) :
-                                               0;
-                        ctx->csw.dDataResidue = residue;
-
-                        usbd_ep_write(dev, USB_MSC_EP_IN, &ctx->csw, sizeof(UsbMscCsw));
-                        FURI_LOG_D(
-                            TAG,
-                            "CSW sent (error): status=%u, tag=%lu, residue=%lu",
-                            ctx->csw.bStatus,
-                            ctx->csw.dTag,
-                            ctx->csw.dDataResidue);
-
-                        ctx->state = MSC_STATE_READ_CBW;
-                        ctx->tx_offset = 0;
-                        ctx->tx_len = 0;
                         break;
                     }
                 }
 
-                // Try to send buffered data
-                if(ctx->tx_len > 0) {
-                    // FURI_LOG_D(TAG, "Sending %lu bytes (offset=%lu)", ctx->tx_len, ctx->tx_offset);
-                    int32_t result =
-                        usbd_ep_write(dev, USB_MSC_EP_IN, ctx->tx_buffer, ctx->tx_len);
-                    if(result < 0) {
-                        FURI_LOG_D(TAG, "usbd_ep_write busy, will retry");
-                        // Endpoint busy - keep data in buffer and retry on next event
-                        break;
-                    }
-                    // Success - mark as sent and clear buffer
-                    ctx->tx_offset += ctx->tx_len;
-                    ctx->tx_len = 0; // Clear buffer to fetch new data next time
-                    // Stay in DATA_IN state, wait for TX complete event
+                if(ctx->device_out > ctx->cbw.dDataLength) {
+                    ctx->csw.bStatus = USB_MSC_CSW_STATUS_PHASE_ERROR;
                 }
-                break;
             }
 
-            case MSC_STATE_DATA_OUT: {
-                // Receive data from host
-                int32_t len = usbd_ep_read(dev, USB_MSC_EP_OUT, ctx->rx_buffer, USB_MSC_EP_SIZE);
+            // The rest of the host data is read and dropped rather than halting OUT:
+            // the controller may have ACKed those packets already and the host would
+            // never see the halt (same reasoning as the Linux mass storage gadget)
+            while(ctx->rx_len + ctx->rx_discarded < ctx->cbw.dDataLength) {
+                BOT_WAIT_EVENT(ctx, usbd_evt_eprx);
+                usb_msc_data_out_discard(ctx, dev);
+            }
+        }
 
-                if(len > 0) {
-                    bool rx_ok = usb_scsi_receive_data(ctx->scsi, ctx->rx_buffer, len);
-                    ctx->rx_len += len;
+        // Host expects more data IN than was sent: halt IN, the host reads the CSW after
+        // clearing the halt instead of waiting for a timeout
+        if((ctx->cbw.bmFlags & USB_MSC_CBW_FLAG_IN) && ctx->tx_offset < ctx->cbw.dDataLength) {
+            ctx->stats.data_stalls++;
 
-                    if(!rx_ok || ctx->rx_len >= ctx->cbw.dDataLength) {
-                        // Data transfer complete or failed
-                        ctx->csw.bStatus = rx_ok ? USB_MSC_CSW_STATUS_PASSED :
-                                                   USB_MSC_CSW_STATUS_FAILED;
+            // A halt drops queued packets, let the data already sent drain first
+            while(!usb_msc_in_idle(ctx)) {
+                BOT_WAIT_EVENT(ctx, usbd_evt_eptx);
+            }
+            usbd_ep_stall(dev, USB_MSC_EP_IN);
+        }
 
-                        // Prepare and send CSW
-                        ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
-                        ctx->csw.dTag = ctx->cbw.dTag;
-                        ctx->csw.dDataResidue = 0;
+        // Status transport
+        usb_msc_build_csw(ctx);
 
-                        usbd_ep_write(dev, USB_MSC_EP_IN, &ctx->csw, sizeof(UsbMscCsw));
-                        FURI_LOG_D(TAG, "CSW sent: status=%u", ctx->csw.bStatus);
+        // Both IN buffers may still hold data or IN may be halted, then the CSW goes out
+        // on a later TX event
+        while(!usb_msc_in_write(ctx, dev, &ctx->csw, sizeof(UsbMscCsw))) {
+            BOT_WAIT_EVENT(ctx, usbd_evt_eptx);
+        }
+        ctx->csw_cycles = DWT->CYCCNT;
+        ctx->csw_pending_cbw = true;
+
+        FURI_LOG_D(
+            TAG,
+            "CSW sent: status=%u, tag=%lu, residue=%lu",
+            ctx->csw.bStatus,
+            ctx->csw.dTag,
+            ctx->csw.dDataResidue);
+    }
+    BOT_END(ctx);
+}
 
-                        ctx->state = MSC_STATE_READ_CBW;
-                    }
-                }
-                break;
-            }
+// Restart the command flow and park it at the CBW read
+static void usb_msc_bot_restart(UsbMscContext* ctx) {
+    // The IN buffers were flushed, packets still counted as queued never complete
+    __atomic_store_n(&ctx->reset_pending, false, __ATOMIC_RELAXED);
+    ctx->in_queued = __atomic_load_n(&ctx->in_completed, __ATOMIC_ACQUIRE);
+    ctx->bot_resume = 0;
+    ctx->csw_pending_cbw = false;
+    usb_msc_bot_run(ctx, ctx->usb_dev, 0);
+}
+
+// Worker thread function - runs the BOT command flow
+static int32_t mass_thread_worker(void* context) {
+    UsbMscContext* ctx = (UsbMscContext*)context;
+
+    FURI_LOG_I(TAG, "Worker thread started");
+
+    // Start with an empty event queue and the flow parked at the CBW read
+    ctx->event_tail = ctx->event_head;
+    ctx->overflows_seen = ctx->stats.event_overflows;
+    usb_msc_bot_restart(ctx);
+
+    // Store thread ID for callbacks
+    ctx->thread_id = furi_thread_get_current_id();
 
-            case MSC_STATE_BUILD_CSW:
-            case MSC_STATE_WRITE_CSW: {
-                // Prepare and send CSW (fallback case)
-                ctx->csw.dSignature = USB_MSC_CSW_SIGNATURE;
-                ctx->csw.dTag = ctx->cbw.dTag;
-                ctx->csw.dDataResidue = 0;
-                // bStatus already set
+    while(1) {
+        uint32_t flags = furi_thread_flags_wait(
+            EventExit | EventReset | EventRxTx, FuriFlagWaitAny, FuriWaitForever);
+
+        // Check for exit
+        if(flags & EventExit) {
+            FURI_LOG_I(TAG, "Worker thread exiting");
+            break;
+        }
 
-                usbd_ep_write(dev, USB_MSC_EP_IN, &ctx->csw, sizeof(UsbMscCsw));
-                FURI_LOG_D(TAG, "CSW sent: status=%u", ctx->csw.bStatus);
+        // Check for reset, events queued after it are for the next command
+        if(flags & EventReset) {
+            FURI_LOG_D(TAG, "Reset event");
+            ctx->stats.resets++;
+            usb_msc_bot_restart(ctx);
+            uint32_t reset_head = __atomic_load_n(&ctx->reset_head, __ATOMIC_RELAXED);
+            if((int32_t)(reset_head - ctx->event_tail) > 0) {
+                __atomic_store_n(&ctx->event_tail, reset_head, __ATOMIC_RELEASE);
+            }
+        }
 
-                ctx->state = MSC_STATE_READ_CBW;
-                break;
+        // Handle endpoint events in the order the USB interrupt queued them, a reset may have
+        // held back events whose EventRxTx was taken by an earlier wakeup
+        if(flags & (EventRxTx | EventReset)) {
+            usbd_device* dev = ctx->usb_dev;
+            UsbMscEvent event;
+            while(usb_msc_event_pop(ctx, &event)) {
+                ctx->stats.events++;
+                if(dev != NULL) usb_msc_bot_run(ctx, dev, event.event);
             }
 
-            case MSC_STATE_IDLE:
-            default:
-                ctx->state = MSC_STATE_READ_CBW;
-                break;
+            // Ring overflowed: events were lost, deliver the one the flow waits for
+            uint32_t overflows = ctx->stats.event_overflows;
+            if(overflows != ctx->overflows_seen && dev != NULL) {
+                ctx->overflows_seen = overflows;
+                usb_msc_bot_run(ctx, dev, ctx->bot_wait);
             }
         }
     }
@@ -649,7 +872,39 @@ void usb_msc_stop(UsbMscContext* ctx) {
 
     g_msc_ctx = NULL;
     ctx->active = false;
-    ctx->state = MSC_STATE_IDLE;
+    ctx->bot_resume = 0;
+
+    // Wakeups per sector, in hundredths
+    uint32_t sectors = ctx->stats.data_in_bytes / SCSI_BLOCK_SIZE;
+    uint32_t per_sector =
+        sectors ? (uint32_t)((uint64_t)ctx->stats.data_in_wakeups * 100 / sectors) : 0;
+    FURI_LOG_I(
+        TAG,
+        "Data IN stats: bytes=%lu, packets=%lu, wakeups=%lu (%lu.%02lu per sector)",
+        ctx->stats.data_in_bytes,
+        ctx->stats.data_in_packets,
+        ctx->stats.data_in_wakeups,
+        per_sector / 100,
+        per_sector % 100);
+    FURI_LOG_I(
+        TAG,
+        "Event stats: handled=%lu, overflows=%lu, fast commands=%lu",
+        ctx->stats.events,
+        ctx->stats.event_overflows,
+        ctx->stats.fast_commands);
+    FURI_LOG_I(
+        TAG,
+        "Turnaround CSW to CBW: count=%lu, avg=%luus, max=%luus, idle gaps=%lu",
+        ctx->stats.turnarounds,
+        ctx->stats.turnarounds ? ctx->stats.turnaround_us_total / ctx->stats.turnarounds : 0,
+        ctx->stats.turnaround_us_max,
+        ctx->stats.idle_gaps);
+    FURI_LOG_I(
+        TAG,
+        "Error stats: data stalls=%lu, phase errors=%lu, resets=%lu",
+        ctx->stats.data_stalls,
+        ctx->stats.phase_errors,
+        ctx->stats.resets);
 
     FURI_LOG_I(TAG, "USB MSC stopped");
 }
@@ -657,3 +912,8 @@ void usb_msc_stop(UsbMscContext* ctx) {
 bool usb_msc_is_active(UsbMscContext* ctx) {
     return ctx != NULL && ctx->active;
 }
+
+void usb_msc_get_stats(UsbMscContext* ctx, UsbMscStats* stats) {
+    if(ctx == NULL || stats == NULL) return;
+    *stats = ctx->stats;
+}
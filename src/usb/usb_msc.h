@@ -51,6 +51,27 @@ typedef struct {
 
 typedef struct UsbMscContext UsbMscContext;
 
+/**
+ * Transfer statistics
+ * wakeups * SCSI_BLOCK_SIZE / bytes is the worker wakeups per sector: 8 when
+ * every wakeup sends a single packet, lower when bursts queue several
+ */
+typedef struct {
+    uint32_t data_in_wakeups; // Worker wakeups that sent data IN packets
+    uint32_t data_in_packets; // Packets queued on the IN endpoint
+    uint32_t data_in_bytes; // Data bytes queued on the IN endpoint
+    uint32_t events; // Endpoint events handled by the worker
+    uint32_t event_overflows; // Endpoint events dropped on a full event queue
+    uint32_t fast_commands; // Commands answered from the SCSI response table
+    uint32_t turnarounds; // CSW to next CBW gaps measured, host idle time excluded
+    uint32_t turnaround_us_total; // Sum of the gaps
+    uint32_t turnaround_us_max; // Longest gap
+    uint32_t idle_gaps; // CSW to next CBW gaps long enough to be host idle time
+    uint32_t data_stalls; // IN halts for data the host expected but did not get
+    uint32_t phase_errors; // CSWs reporting a phase error
+    uint32_t resets; // BOT resets and reconfigurations
+} UsbMscStats;
+
 /**
  * Allocate USB MSC context
  * @return Context pointer or NULL on error
@@ -90,3 +111,10 @@ void usb_msc_stop(UsbMscContext* ctx);
  * @return true if active
  */
 bool usb_msc_is_active(UsbMscContext* ctx);
+
+/**
+ * Get transfer statistics
+ * @param ctx MSC context
+ * @param stats Output statistics
+ */
+void usb_msc_get_stats(UsbMscContext* ctx, UsbMscStats* stats);
@@ -3,6 +3,85 @@
 
 #define TAG "UsbScsi"
 
+// Stager thread events
+typedef enum {
+    ScsiStagerEventRun = (1 << 0),
+    ScsiStagerEventExit = (1 << 1),
+} ScsiStagerEventFlag;
+
+// Standard INQUIRY response
+static const uint8_t scsi_inquiry_standard[SCSI_INQUIRY_DATA_SIZE] = {
+    SCSI_DEVICE_TYPE_DIRECT_ACCESS, // Peripheral Device Type
+    0x80, // Removable
+    0x00, // Version
+    0x02, // Response Data Format
+    0x1F, // Additional Length
+    0x00, // Reserved
+    0x00, // Reserved
+    0x00, // Reserved
+    // Vendor ID (8 bytes)
+    'F',
+    'L',
+    'I',
+    'P',
+    'P',
+    'E',
+    'R',
+    ' ',
+    // Product ID (16 bytes)
+    'B',
+    'o',
+    'o',
+    't',
+    '2',
+    'F',
+    'l',
+    'i',
+    'p',
+    'p',
+    'e',
+    'r',
+    ' ',
+    ' ',
+    ' ',
+    ' ',
+    // Product Revision (4 bytes)
+    '1',
+    '.',
+    '0',
+    ' '};
+
+// INQUIRY VPD page 0x00: Supported VPD Pages
+static const uint8_t scsi_vpd_supported_pages[6] = {
+    SCSI_DEVICE_TYPE_DIRECT_ACCESS, // Peripheral Device Type
+    0x00, // Page Code
+    0x00, // Reserved
+    0x02, // Page Length (2 bytes following)
+    0x00, // Supported page: 0x00 (this page)
+    0x80 // Supported page: 0x80 (unit serial number)
+};
+
+// INQUIRY VPD page 0x80: Unit Serial Number
+static const uint8_t scsi_vpd_unit_serial[8] = {
+    SCSI_DEVICE_TYPE_DIRECT_ACCESS, // Peripheral Device Type
+    0x80, // Page Code
+    0x00, // Reserved
+    0x04, // Page Length (4 bytes following)
+    'F',
+    'L',
+    'P',
+    '0' // Serial number: FLP0
+};
+
+// Responses that depend on the block device, rebuilt whenever it changes
+typedef struct {
+    uint8_t capacity_10[8]; // READ_CAPACITY_10: last LBA, block length
+    uint8_t format_capacity[12]; // READ_FORMAT_CAPACITIES: header and one descriptor
+    uint8_t mode_sense_6[4]; // MODE_SENSE_6 header, no block descriptors
+    uint8_t mode_sense_10[8]; // MODE_SENSE_10 header, no block descriptors
+    uint8_t sense[SCSI_SENSE_DATA_SIZE]; // REQUEST_SENSE, filled per command
+} ScsiResponses;
+
 typedef enum {
     SCSI_STATE_IDLE,
     SCSI_STATE_TX_DATA,
@@ -10,8 +89,8 @@ typedef enum {
 } ScsiState;
 
 struct UsbScsiContext {
-    Storage* storage;
-    VirtualFat* vfat;
+    BlockDevice* device;
+    uint32_t block_count; // Cached geometry of device
     bool active;
 
     // Command state
@@ -21,53 +100,192 @@ struct UsbScsiContext {
 
     // Data transmission mode
     bool is_small_data_mode; // true for INQUIRY/MODE_SENSE, false for READ_10
+    const uint8_t* response; // Small data mode: bytes sent from the response table
+    uint16_t allocation_length; // Response bytes the current CDB allows
+    ScsiResponses responses;
 
     // READ_10 / WRITE_10 state
     uint32_t current_lba;
     uint32_t remaining_blocks;
-    uint8_t block_buffer[SCSI_BLOCK_SIZE];
+    uint8_t* staging_buffer; // USB_SCSI_STAGING_SECTORS * SCSI_BLOCK_SIZE bytes
+    size_t staging_len; // Valid bytes in staging_buffer (sector mode)
+    // READ_10: bytes of staging_buffer already sent
+    // WRITE_10: bytes of staging_buffer already received
     size_t buffer_offset;
+
+    // READ_10 ping-pong: the stager thread reads the next run into next_buffer
+    // while staging_buffer drains to the endpoint
+    uint8_t* next_buffer; // Same size as staging_buffer, swapped in when it drains
+    size_t next_len; // Bytes of the run handed to the stager (0 = none)
+    bool next_pending; // Handed to the stager, stage_done not taken yet
+    FuriThread* stager;
+    FuriSemaphore* stage_done; // Released by the stager when its run is read
+    uint32_t stage_lba; // Run for the stager, set before it is woken
+    uint32_t stage_count;
+    bool stage_success; // Set by the stager before stage_done
+
+    // Statistics
+    uint32_t staged_runs; // Runs read by the stager
+    uint32_t ahead_runs; // Runs that were ready when the endpoint needed them
+    uint32_t stalls; // Runs the endpoint had to wait for
 };
 
+static void scsi_build_responses(UsbScsiContext* ctx) {
+    ScsiResponses* r = &ctx->responses;
+    uint32_t last_lba = ctx->block_count - 1;
+    uint8_t write_protect = block_device_is_read_only(ctx->device) ? 0x80 : 0x00;
+
+    // READ_CAPACITY_10: last LBA and block length, big-endian
+    r->capacity_10[0] = (last_lba >> 24) & 0xFF;
+    r->capacity_10[1] = (last_lba >> 16) & 0xFF;
+    r->capacity_10[2] = (last_lba >> 8) & 0xFF;
+    r->capacity_10[3] = last_lba & 0xFF;
+    r->capacity_10[4] = (SCSI_BLOCK_SIZE >> 24) & 0xFF;
+    r->capacity_10[5] = (SCSI_BLOCK_SIZE >> 16) & 0xFF;
+    r->capacity_10[6] = (SCSI_BLOCK_SIZE >> 8) & 0xFF;
+    r->capacity_10[7] = SCSI_BLOCK_SIZE & 0xFF;
+
+    // READ_FORMAT_CAPACITIES: Capacity List Header (4 bytes) + Capacity Descriptor (8 bytes)
+    memset(r->format_capacity, 0, sizeof(r->format_capacity));
+    r->format_capacity[3] = 0x08; // Capacity List Length
+    memcpy(r->format_capacity + 4, r->capacity_10, 4); // Number of blocks (max LBA)
+    r->format_capacity[8] = 0x02; // Descriptor Code: 0x02 = Formatted Media
+    r->format_capacity[9] = (SCSI_BLOCK_SIZE >> 16) & 0xFF; // Block Length
+    r->format_capacity[10] = (SCSI_BLOCK_SIZE >> 8) & 0xFF;
+    r->format_capacity[11] = SCSI_BLOCK_SIZE & 0xFF;
+
+    // MODE_SENSE_6: minimal header
+    r->mode_sense_6[0] = 0x03; // Mode data length
+    r->mode_sense_6[1] = 0x00; // Medium type
+    r->mode_sense_6[2] = write_protect; // Bit 7 = write protected
+    r->mode_sense_6[3] = 0x00; // Block descriptor length
+
+    // MODE_SENSE_10: minimal header, mode data length (big-endian) is 6 additional bytes
+    memset(r->mode_sense_10, 0, sizeof(r->mode_sense_10));
+    r->mode_sense_10[1] = 0x06;
+    r->mode_sense_10[3] = write_protect; // Bit 7 = write protected
+}
+
+static int32_t scsi_stager_worker(void* context) {
+    UsbScsiContext* ctx = context;
+
+    while(true) {
+        uint32_t flags = furi_thread_flags_wait(
+            ScsiStagerEventRun | ScsiStagerEventExit, FuriFlagWaitAny, FuriWaitForever);
+        if(flags & ScsiStagerEventExit) break;
+
+        ctx->stage_success = block_device_read_blocks(
+            ctx->device, ctx->stage_lba, ctx->stage_count, ctx->next_buffer);
+        furi_semaphore_release(ctx->stage_done);
+    }
+
+    return 0;
+}
+
 UsbScsiContext* usb_scsi_alloc(void) {
     UsbScsiContext* ctx = malloc(sizeof(UsbScsiContext));
     memset(ctx, 0, sizeof(UsbScsiContext));
 
-    ctx->vfat = NULL;
+    ctx->device = NULL;
     ctx->active = false;
     ctx->state = SCSI_STATE_IDLE;
     ctx->sense_key = SCSI_SENSE_NO_SENSE;
     ctx->asc = 0;
 
+    // Staging buffers hold a whole run of sectors read in one go
+    ctx->staging_buffer = malloc(USB_SCSI_STAGING_SECTORS * SCSI_BLOCK_SIZE);
+    ctx->next_buffer = malloc(USB_SCSI_STAGING_SECTORS * SCSI_BLOCK_SIZE);
+
+    ctx->stage_done = furi_semaphore_alloc(1, 0);
+    ctx->stager = furi_thread_alloc_ex("UsbScsiStager", 2048, scsi_stager_worker, ctx);
+    furi_thread_start(ctx->stager);
+
+    scsi_build_responses(ctx);
+
     return ctx;
 }
 
+// Wait out a run still in flight from an aborted READ_10 and drop it, the
+// stager must be idle before the device or the staging buffers change
+static void scsi_stage_cancel(UsbScsiContext* ctx) {
+    if(ctx->next_pending) {
+        furi_semaphore_acquire(ctx->stage_done, FuriWaitForever);
+        ctx->next_pending = false;
+    }
+    ctx->next_len = 0;
+}
+
+// Hand the next run of READ_10 sectors to the stager
+static void scsi_stage_start(UsbScsiContext* ctx) {
+    uint32_t count = ctx->remaining_blocks;
+    if(count > USB_SCSI_STAGING_SECTORS) count = USB_SCSI_STAGING_SECTORS;
+
+    ctx->stage_lba = ctx->current_lba;
+    ctx->stage_count = count;
+    ctx->current_lba += count;
+    ctx->remaining_blocks -= count;
+    ctx->next_len = count * SCSI_BLOCK_SIZE;
+    ctx->next_pending = true;
+
+    furi_thread_flags_set(furi_thread_get_id(ctx->stager), ScsiStagerEventRun);
+}
+
 void usb_scsi_free(UsbScsiContext* ctx) {
     if(ctx == NULL) return;
+
+    scsi_stage_cancel(ctx);
+    furi_thread_flags_set(furi_thread_get_id(ctx->stager), ScsiStagerEventExit);
+    furi_thread_join(ctx->stager);
+    furi_thread_free(ctx->stager);
+    furi_semaphore_free(ctx->stage_done);
+
+    FURI_LOG_I(
+        TAG,
+        "Stats: staged=%lu, ahead=%lu, stalls=%lu",
+        ctx->staged_runs,
+        ctx->ahead_runs,
+        ctx->stalls);
+
+    free(ctx->next_buffer);
+    free(ctx->staging_buffer);
     free(ctx);
 }
 
-bool usb_scsi_set_virtual_fat(UsbScsiContext* ctx, VirtualFat* vfat) {
-    if(ctx == NULL || vfat == NULL) {
+bool usb_scsi_set_block_device(UsbScsiContext* ctx, BlockDevice* device) {
+    if(ctx == NULL || device == NULL) {
         FURI_LOG_E(TAG, "Invalid parameters");
         return false;
     }
 
-    ctx->vfat = vfat;
+    scsi_stage_cancel(ctx);
+
+    BlockDeviceGeometry geometry;
+    if(!block_device_get_geometry(device, &geometry) || geometry.block_count == 0 ||
+       geometry.block_size != SCSI_BLOCK_SIZE) {
+        FURI_LOG_E(TAG, "Unsupported block device geometry");
+        return false;
+    }
+
+    ctx->device = device;
+    ctx->block_count = geometry.block_count;
     ctx->active = true;
+    scsi_build_responses(ctx);
 
-    FURI_LOG_I(TAG, "Virtual FAT set, total sectors: %lu", virtual_fat_get_total_sectors(vfat));
+    FURI_LOG_I(TAG, "Block device set, total sectors: %lu", ctx->block_count);
     return true;
 }
 
 void usb_scsi_clear(UsbScsiContext* ctx) {
     if(ctx == NULL) return;
 
-    ctx->vfat = NULL;
+    scsi_stage_cancel(ctx);
+    ctx->device = NULL;
+    ctx->block_count = 0;
     ctx->active = false;
     ctx->state = SCSI_STATE_IDLE;
+    scsi_build_responses(ctx);
 
-    FURI_LOG_I(TAG, "Virtual FAT cleared");
+    FURI_LOG_I(TAG, "Backend cleared");
 }
 
 static void scsi_set_sense(UsbScsiContext* ctx, uint8_t sense_key, uint8_t asc) {
@@ -81,143 +299,81 @@ static bool scsi_cmd_test_unit_ready(UsbScsiContext* ctx) {
     return true;
 }
 
-static bool scsi_cmd_inquiry(UsbScsiContext* ctx, uint8_t* cmd) {
-    FURI_LOG_D(TAG, "SCSI: INQUIRY");
+// CDB allocation length of commands with a short response, the response is cut to it
+static uint16_t scsi_allocation_length(const uint8_t* cmd) {
+    switch(cmd[0]) {
+    case SCSI_CMD_INQUIRY:
+        return ((uint16_t)cmd[3] << 8) | cmd[4];
+    case SCSI_CMD_REQUEST_SENSE:
+    case SCSI_CMD_MODE_SENSE_6:
+        return cmd[4];
+    case SCSI_CMD_MODE_SENSE_10:
+    case SCSI_CMD_READ_FORMAT_CAPACITY:
+        return ((uint16_t)cmd[7] << 8) | cmd[8];
+    default:
+        return UINT16_MAX;
+    }
+}
+
+// Send a short response straight from the response table, without copying it
+static void scsi_tx_response(UsbScsiContext* ctx, const uint8_t* data, size_t len) {
+    if(len > ctx->allocation_length) len = ctx->allocation_length;
+    ctx->response = data;
+    ctx->is_small_data_mode = true; // Byte-based transmission
+    ctx->buffer_offset = 0;
+    ctx->remaining_blocks = len;
+    ctx->state = len > 0 ? SCSI_STATE_TX_DATA : SCSI_STATE_IDLE; // Allocation length 0
+}
 
+// INQUIRY response for the requested page, NULL if the page is not supported
+static const uint8_t* scsi_inquiry_response(const uint8_t* cmd, size_t* len) {
     // Check for VPD (Vital Product Data)
     bool evpd = (cmd[1] & 0x01) != 0;
     uint8_t page_code = cmd[2];
 
-    if(evpd) {
-        // VPD page requested
-        if(page_code == 0x00) {
-            // Supported VPD Pages
-            FURI_LOG_D(TAG, "INQUIRY: VPD Supported Pages (0x00)");
-            uint8_t vpd_data[6] = {
-                SCSI_DEVICE_TYPE_DIRECT_ACCESS, // Peripheral Device Type
-                0x00, // Page Code
-                0x00, // Reserved
-                0x02, // Page Length (2 bytes following)
-                0x00, // Supported page: 0x00 (this page)
-                0x80 // Supported page: 0x80 (unit serial number)
-            };
-            memcpy(ctx->block_buffer, vpd_data, 6);
-            ctx->is_small_data_mode = true;
-            ctx->buffer_offset = 0;
-            ctx->remaining_blocks = 6;
-            ctx->state = SCSI_STATE_TX_DATA;
-            return true;
-        } else if(page_code == 0x80) {
-            // Unit Serial Number
-            FURI_LOG_D(TAG, "INQUIRY: VPD Unit Serial Number (0x80)");
-            uint8_t vpd_data[8] = {
-                SCSI_DEVICE_TYPE_DIRECT_ACCESS, // Peripheral Device Type
-                0x80, // Page Code
-                0x00, // Reserved
-                0x04, // Page Length (4 bytes following)
-                'F',
-                'L',
-                'P',
-                '0' // Serial number: FLP0
-            };
-            memcpy(ctx->block_buffer, vpd_data, 8);
-            ctx->is_small_data_mode = true;
-            ctx->buffer_offset = 0;
-            ctx->remaining_blocks = 8;
-            ctx->state = SCSI_STATE_TX_DATA;
-            return true;
-        } else {
-            // Unsupported VPD page
-            FURI_LOG_W(TAG, "INQUIRY: Unsupported VPD page 0x%02X", page_code);
-            scsi_set_sense(ctx, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_FIELD_IN_CDB);
-            return false;
-        }
+    if(!evpd) {
+        *len = sizeof(scsi_inquiry_standard);
+        return scsi_inquiry_standard;
+    } else if(page_code == 0x00) {
+        *len = sizeof(scsi_vpd_supported_pages);
+        return scsi_vpd_supported_pages;
+    } else if(page_code == 0x80) {
+        *len = sizeof(scsi_vpd_unit_serial);
+        return scsi_vpd_unit_serial;
     }
+    return NULL;
+}
 
-    // Standard INQUIRY response
-    FURI_LOG_D(TAG, "INQUIRY: Standard");
-    uint8_t inquiry_data[SCSI_INQUIRY_DATA_SIZE] = {
-        SCSI_DEVICE_TYPE_DIRECT_ACCESS, // Peripheral Device Type
-        0x80, // Removable
-        0x00, // Version
-        0x02, // Response Data Format
-        0x1F, // Additional Length
-        0x00, // Reserved
-        0x00, // Reserved
-        0x00, // Reserved
-        // Vendor ID (8 bytes)
-        'F',
-        'L',
-        'I',
-        'P',
-        'P',
-        'E',
-        'R',
-        ' ',
-        // Product ID (16 bytes)
-        'B',
-        'o',
-        'o',
-        't',
-        '2',
-        'F',
-        'l',
-        'i',
-        'p',
-        'p',
-        'e',
-        'r',
-        ' ',
-        ' ',
-        ' ',
-        ' ',
-        // Product Revision (4 bytes)
-        '1',
-        '.',
-        '0',
-        ' '};
-
-    memcpy(ctx->block_buffer, inquiry_data, SCSI_INQUIRY_DATA_SIZE);
-    ctx->is_small_data_mode = true; // Byte-based transmission
-    ctx->buffer_offset = 0;
-    ctx->remaining_blocks = SCSI_INQUIRY_DATA_SIZE;
-    ctx->state = SCSI_STATE_TX_DATA;
+static bool scsi_cmd_inquiry(UsbScsiContext* ctx, uint8_t* cmd) {
+    FURI_LOG_D(TAG, "SCSI: INQUIRY evpd=%u page=0x%02X", cmd[1] & 0x01, cmd[2]);
+
+    size_t len;
+    const uint8_t* response = scsi_inquiry_response(cmd, &len);
+    if(response == NULL) {
+        // Unsupported VPD page
+        FURI_LOG_W(TAG, "INQUIRY: Unsupported VPD page 0x%02X", cmd[2]);
+        scsi_set_sense(ctx, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_INVALID_FIELD_IN_CDB);
+        return false;
+    }
 
+    scsi_tx_response(ctx, response, len);
     return true;
 }
 
 static bool scsi_cmd_read_capacity_10(UsbScsiContext* ctx) {
     FURI_LOG_D(TAG, "SCSI: READ_CAPACITY_10");
 
-    if(!ctx->vfat) {
+    if(!ctx->device) {
         scsi_set_sense(ctx, SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
         return false;
     }
 
-    uint32_t total_blocks = virtual_fat_get_total_sectors(ctx->vfat);
-    uint32_t last_lba = total_blocks - 1;
-
-    // Prepare response (8 bytes)
-    ctx->block_buffer[0] = (last_lba >> 24) & 0xFF;
-    ctx->block_buffer[1] = (last_lba >> 16) & 0xFF;
-    ctx->block_buffer[2] = (last_lba >> 8) & 0xFF;
-    ctx->block_buffer[3] = last_lba & 0xFF;
-
-    ctx->block_buffer[4] = (SCSI_BLOCK_SIZE >> 24) & 0xFF;
-    ctx->block_buffer[5] = (SCSI_BLOCK_SIZE >> 16) & 0xFF;
-    ctx->block_buffer[6] = (SCSI_BLOCK_SIZE >> 8) & 0xFF;
-    ctx->block_buffer[7] = SCSI_BLOCK_SIZE & 0xFF;
-
-    ctx->is_small_data_mode = true; // Byte-based transmission
-    ctx->buffer_offset = 0;
-    ctx->remaining_blocks = 8;
-    ctx->state = SCSI_STATE_TX_DATA;
-
+    scsi_tx_response(ctx, ctx->responses.capacity_10, sizeof(ctx->responses.capacity_10));
     return true;
 }
 
 static bool scsi_cmd_read_10(UsbScsiContext* ctx, uint8_t* cmd) {
-    if(!ctx->vfat) {
+    if(!ctx->device) {
         scsi_set_sense(ctx, SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
         return false;
     }
@@ -230,8 +386,8 @@ static bool scsi_cmd_read_10(UsbScsiContext* ctx, uint8_t* cmd) {
     FURI_LOG_D(TAG, "SCSI: READ_10 LBA=%lu, Length=%u", lba, length);
 
     // Check bounds
-    uint32_t total_blocks = virtual_fat_get_total_sectors(ctx->vfat);
-    if(lba + length > total_blocks) {
+    uint32_t total_blocks = ctx->block_count;
+    if(length > total_blocks || lba > total_blocks - length) {
         FURI_LOG_E(TAG, "READ_10: LBA out of range");
         scsi_set_sense(ctx, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_LBA_OUT_OF_RANGE);
         return false;
@@ -240,90 +396,78 @@ static bool scsi_cmd_read_10(UsbScsiContext* ctx, uint8_t* cmd) {
     ctx->is_small_data_mode = false; // Sector-based transmission
     ctx->current_lba = lba;
     ctx->remaining_blocks = length;
+    ctx->staging_len = 0;
     ctx->buffer_offset = 0;
     ctx->state = SCSI_STATE_TX_DATA;
 
+    // Let the backend fetch the whole command ahead of the host, off this thread
+    block_device_prefetch(ctx->device, lba, length);
+
+    // The first run is read while the MSC worker finishes the CBW
+    if(length > 0) scsi_stage_start(ctx);
+
     return true;
 }
 
-static bool scsi_cmd_mode_sense_6(UsbScsiContext* ctx) {
-    FURI_LOG_D(TAG, "SCSI: MODE_SENSE_6");
+static bool scsi_cmd_write_10(UsbScsiContext* ctx, uint8_t* cmd) {
+    if(!ctx->device) {
+        scsi_set_sense(ctx, SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
+        return false;
+    }
 
-    // Return minimal mode sense data
-    uint8_t mode_sense_data[4] = {
-        0x03, // Mode data length
-        0x00, // Medium type
-        0x80, // Device specific parameter (bit 7 = write protected)
-        0x00 // Block descriptor length
-    };
+    if(block_device_is_read_only(ctx->device)) {
+        FURI_LOG_W(TAG, "SCSI: WRITE_10 not supported (read-only)");
+        scsi_set_sense(ctx, SCSI_SENSE_DATA_PROTECT, SCSI_ASC_WRITE_PROTECTED);
+        return false;
+    }
 
-    memcpy(ctx->block_buffer, mode_sense_data, 4);
-    ctx->is_small_data_mode = true; // Byte-based transmission
+    // Parse LBA and length from command
+    uint32_t lba = ((uint32_t)cmd[2] << 24) | ((uint32_t)cmd[3] << 16) | ((uint32_t)cmd[4] << 8) |
+                   cmd[5];
+    uint16_t length = ((uint16_t)cmd[7] << 8) | cmd[8];
+
+    FURI_LOG_D(TAG, "SCSI: WRITE_10 LBA=%lu, Length=%u", lba, length);
+
+    // Check bounds
+    uint32_t total_blocks = ctx->block_count;
+    if(length > total_blocks || lba > total_blocks - length) {
+        FURI_LOG_E(TAG, "WRITE_10: LBA out of range");
+        scsi_set_sense(ctx, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ASC_LBA_OUT_OF_RANGE);
+        return false;
+    }
+
+    // Data lands in the staging buffer via usb_scsi_rx_peek, each full run is written at once
+    ctx->is_small_data_mode = false;
+    ctx->current_lba = lba;
+    ctx->remaining_blocks = length;
     ctx->buffer_offset = 0;
-    ctx->remaining_blocks = 4;
-    ctx->state = SCSI_STATE_TX_DATA;
+    ctx->state = length > 0 ? SCSI_STATE_RX_DATA : SCSI_STATE_IDLE;
 
     return true;
 }
 
+static bool scsi_cmd_mode_sense_6(UsbScsiContext* ctx) {
+    FURI_LOG_D(TAG, "SCSI: MODE_SENSE_6");
+    scsi_tx_response(ctx, ctx->responses.mode_sense_6, sizeof(ctx->responses.mode_sense_6));
+    return true;
+}
+
 static bool scsi_cmd_mode_sense_10(UsbScsiContext* ctx) {
     FURI_LOG_D(TAG, "SCSI: MODE_SENSE_10");
-
-    // Return minimal mode sense data (10-byte version)
-    uint8_t mode_sense_data[8] = {
-        0x00,
-        0x06, // Mode data length (big-endian) - 6 additional bytes
-        0x00, // Medium type
-        0x80, // Device specific parameter (bit 7 = write protected)
-        0x00,
-        0x00, // Reserved
-        0x00,
-        0x00 // Block descriptor length (no block descriptors)
-    };
-
-    memcpy(ctx->block_buffer, mode_sense_data, 8);
-    ctx->is_small_data_mode = true; // Byte-based transmission
-    ctx->buffer_offset = 0;
-    ctx->remaining_blocks = 8;
-    ctx->state = SCSI_STATE_TX_DATA;
-
+    scsi_tx_response(ctx, ctx->responses.mode_sense_10, sizeof(ctx->responses.mode_sense_10));
     return true;
 }
 
 static bool scsi_cmd_read_format_capacities(UsbScsiContext* ctx) {
     FURI_LOG_D(TAG, "SCSI: READ_FORMAT_CAPACITIES");
 
-    if(!ctx->vfat) {
+    if(!ctx->device) {
         scsi_set_sense(ctx, SCSI_SENSE_NOT_READY, SCSI_ASC_MEDIUM_NOT_PRESENT);
         return false;
     }
 
-    uint32_t total_blocks = virtual_fat_get_total_sectors(ctx->vfat);
-    uint32_t last_lba = total_blocks - 1;
-
-    // Format: Capacity List Header (4 bytes) + Current/Maximum Capacity Descriptor (8 bytes)
-    uint8_t format_data[12] = {
-        0x00,
-        0x00,
-        0x00,
-        0x08, // Capacity List Header: Reserved (3) + Capacity List Length (1)
-
-        // Current/Maximum Capacity Descriptor
-        (last_lba >> 24) & 0xFF, // Number of blocks (max LBA)
-        (last_lba >> 16) & 0xFF,
-        (last_lba >> 8) & 0xFF,
-        last_lba & 0xFF,
-        0x02, // Descriptor Code: 0x02 = Formatted Media
-        (SCSI_BLOCK_SIZE >> 16) & 0xFF, // Block Length
-        (SCSI_BLOCK_SIZE >> 8) & 0xFF,
-        SCSI_BLOCK_SIZE & 0xFF};
-
-    memcpy(ctx->block_buffer, format_data, 12);
-    ctx->is_small_data_mode = true; // Byte-based transmission
-    ctx->buffer_offset = 0;
-    ctx->remaining_blocks = 12;
-    ctx->state = SCSI_STATE_TX_DATA;
-
+    scsi_tx_response(
+        ctx, ctx->responses.format_capacity, sizeof(ctx->responses.format_capacity));
     return true;
 }
 
@@ -332,10 +476,11 @@ bool usb_scsi_process_command(UsbScsiContext* ctx, uint8_t* cmd, uint8_t cmd_len
         return false;
     }
 
-    // Reset state
+    // Reset state, sense data is kept for REQUEST_SENSE to report
+    scsi_stage_cancel(ctx);
     ctx->state = SCSI_STATE_IDLE;
-    ctx->sense_key = SCSI_SENSE_NO_SENSE;
-    ctx->asc = 0;
+    if(cmd[0] != SCSI_CMD_REQUEST_SENSE) scsi_set_sense(ctx, SCSI_SENSE_NO_SENSE, 0);
+    ctx->allocation_length = scsi_allocation_length(cmd);
 
     uint8_t opcode = cmd[0];
 
@@ -364,11 +509,8 @@ bool usb_scsi_process_command(UsbScsiContext* ctx, uint8_t* cmd, uint8_t cmd_len
     case SCSI_CMD_REQUEST_SENSE:
         FURI_LOG_D(TAG, "SCSI: REQUEST_SENSE");
         // Prepare sense data response (18 bytes)
-        usb_scsi_get_sense_data(ctx, ctx->block_buffer);
-        ctx->is_small_data_mode = true; // Byte-based transmission
-        ctx->buffer_offset = 0;
-        ctx->remaining_blocks = SCSI_SENSE_DATA_SIZE;
-        ctx->state = SCSI_STATE_TX_DATA;
+        usb_scsi_get_sense_data(ctx, ctx->responses.sense);
+        scsi_tx_response(ctx, ctx->responses.sense, SCSI_SENSE_DATA_SIZE);
         return true;
 
     case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
@@ -391,10 +533,7 @@ bool usb_scsi_process_command(UsbScsiContext* ctx, uint8_t* cmd, uint8_t cmd_len
     }
 
     case SCSI_CMD_WRITE_10:
-        // Read-only filesystem
-        FURI_LOG_W(TAG, "SCSI: WRITE_10 not supported (read-only)");
-        scsi_set_sense(ctx, SCSI_SENSE_DATA_PROTECT, 0x27); // Write protected
-        return false;
+        return scsi_cmd_write_10(ctx, cmd);
 
     default:
         FURI_LOG_W(TAG, "SCSI: Unknown command 0x%02X", opcode);
@@ -403,28 +542,124 @@ bool usb_scsi_process_command(UsbScsiContext* ctx, uint8_t* cmd, uint8_t cmd_len
     }
 }
 
-size_t usb_scsi_transmit_data(UsbScsiContext* ctx, uint8_t* buffer, size_t max_len) {
-    if(ctx == NULL || buffer == NULL) {
+bool usb_scsi_fast_command(
+    UsbScsiContext* ctx,
+    const uint8_t* cmd,
+    uint8_t cmd_len,
+    uint32_t host_length,
+    const uint8_t** data,
+    size_t* len) {
+    if(ctx == NULL || cmd == NULL || cmd_len == 0 || data == NULL || len == NULL) {
+        return false;
+    }
+
+    const uint8_t* response = NULL;
+    size_t response_len = 0;
+
+    switch(cmd[0]) {
+    case SCSI_CMD_TEST_UNIT_READY:
+        break;
+
+    case SCSI_CMD_INQUIRY:
+        response = scsi_inquiry_response(cmd, &response_len);
+        if(response == NULL) return false;
+        break;
+
+    case SCSI_CMD_READ_CAPACITY_10:
+        if(!ctx->device) return false;
+        response = ctx->responses.capacity_10;
+        response_len = sizeof(ctx->responses.capacity_10);
+        break;
+
+    case SCSI_CMD_MODE_SENSE_6:
+        response = ctx->responses.mode_sense_6;
+        response_len = sizeof(ctx->responses.mode_sense_6);
+        break;
+
+    case SCSI_CMD_MODE_SENSE_10:
+        response = ctx->responses.mode_sense_10;
+        response_len = sizeof(ctx->responses.mode_sense_10);
+        break;
+
+    case SCSI_CMD_REQUEST_SENSE:
+        response = ctx->responses.sense;
+        response_len = SCSI_SENSE_DATA_SIZE;
+        break;
+
+    default:
+        // Failures and everything else take the usb_scsi_process_command path
+        return false;
+    }
+
+    // Only exact transfers, a length mismatch needs the full BOT case handling
+    uint16_t allocation_length = scsi_allocation_length(cmd);
+    if(response_len > allocation_length) response_len = allocation_length;
+    if(response_len != host_length) return false;
+
+    // Same effect as usb_scsi_process_command, the response is staged as data IN
+    if(cmd[0] == SCSI_CMD_REQUEST_SENSE) {
+        usb_scsi_get_sense_data(ctx, ctx->responses.sense);
+    } else {
+        scsi_set_sense(ctx, SCSI_SENSE_NO_SENSE, 0);
+    }
+    ctx->allocation_length = allocation_length;
+    scsi_tx_response(ctx, response, response_len);
+
+    *data = response;
+    *len = response_len;
+    return true;
+}
+
+// Take the run from the stager, waiting if it is still being read, and swap it in
+static bool scsi_stage_finish(UsbScsiContext* ctx) {
+    // The first run of a command has nothing to overlap with, it is neither ahead nor a stall
+    bool first = ctx->staging_len == 0;
+    if(furi_semaphore_acquire(ctx->stage_done, 0) == FuriStatusOk) {
+        if(!first) ctx->ahead_runs++;
+    } else {
+        if(!first) ctx->stalls++;
+        furi_semaphore_acquire(ctx->stage_done, FuriWaitForever);
+    }
+    ctx->next_pending = false;
+    ctx->staged_runs++;
+
+    if(!ctx->stage_success) {
+        FURI_LOG_E(TAG, "Failed to read sectors %lu+%lu", ctx->stage_lba, ctx->stage_count);
+        scsi_set_sense(ctx, SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_UNRECOVERED_READ);
+        ctx->next_len = 0;
+        return false;
+    }
+
+    uint8_t* drained = ctx->staging_buffer;
+    ctx->staging_buffer = ctx->next_buffer;
+    ctx->staging_len = ctx->next_len;
+    ctx->next_buffer = drained;
+    ctx->next_len = 0;
+    ctx->buffer_offset = 0;
+
+    // The following run is read while this one drains
+    if(ctx->remaining_blocks > 0) scsi_stage_start(ctx);
+
+    return true;
+}
+
+size_t usb_scsi_tx_peek(UsbScsiContext* ctx, const uint8_t** data) {
+    if(ctx == NULL || data == NULL) {
         FURI_LOG_E(TAG, "TX: NULL params");
         return 0;
     }
 
+    *data = NULL;
+
     if(ctx->state != SCSI_STATE_TX_DATA) {
         FURI_LOG_D(TAG, "TX: not in TX_DATA state (state=%d)", ctx->state);
         return 0;
     }
 
-    Storage* storage = ctx->storage;
-    size_t bytes_to_send = 0;
-
-    // FURI_LOG_D(TAG, "TX: remaining=%u, offset=%u, lba=%lu, mode=%s",
-    //            (unsigned int)ctx->remaining_blocks, (unsigned int)ctx->buffer_offset,
-    //            ctx->current_lba, ctx->is_small_data_mode ? "byte" : "sector");
-
     if(ctx->is_small_data_mode) {
         // Small data response (INQUIRY, MODE_SENSE, etc.)
         // remaining_blocks = total bytes to send
-        // Data is already in block_buffer
+        // Data is in the response table
 
         // Check if all data already sent
         if(ctx->buffer_offset >= ctx->remaining_blocks) {
@@ -433,72 +668,120 @@ size_t usb_scsi_transmit_data(UsbScsiContext* ctx, uint8_t* buffer, size_t max_l
             return 0;
         }
 
-        size_t available = ctx->remaining_blocks - ctx->buffer_offset;
-        bytes_to_send = (available < max_len) ? available : max_len;
+        *data = ctx->response + ctx->buffer_offset;
+        return ctx->remaining_blocks - ctx->buffer_offset;
+    }
+
+    // Sector-based response (READ_10)
+    // remaining_blocks = number of 512-byte sectors not yet staged
+
+    // Check if all sectors sent and buffers drained
+    if(ctx->remaining_blocks == 0 && ctx->next_len == 0 &&
+       ctx->buffer_offset >= ctx->staging_len) {
+        FURI_LOG_D(TAG, "TX: all sectors complete");
+        ctx->state = SCSI_STATE_IDLE;
+        return 0;
+    }
+
+    // Staging buffer drained? Swap in the next run, the stager has usually read it already
+    if(ctx->buffer_offset >= ctx->staging_len && !scsi_stage_finish(ctx)) {
+        ctx->state = SCSI_STATE_IDLE;
+        return 0;
+    }
+
+    *data = ctx->staging_buffer + ctx->buffer_offset;
+    return ctx->staging_len - ctx->buffer_offset;
+}
+
+void usb_scsi_tx_consume(UsbScsiContext* ctx, size_t len) {
+    if(ctx == NULL || ctx->state != SCSI_STATE_TX_DATA) return;
 
-        memcpy(buffer, ctx->block_buffer + ctx->buffer_offset, bytes_to_send);
-        ctx->buffer_offset += bytes_to_send;
+    ctx->buffer_offset += len;
 
+    if(ctx->is_small_data_mode) {
         if(ctx->buffer_offset >= ctx->remaining_blocks) {
             // All data sent
             ctx->state = SCSI_STATE_IDLE;
             ctx->remaining_blocks = 0;
         }
-    } else {
-        // Sector-based response (READ_10)
-        // remaining_blocks = number of 512-byte sectors
+    } else if(ctx->buffer_offset >= ctx->staging_len && ctx->next_len == 0) {
+        // All sectors sent, nothing left with the stager
+        ctx->state = SCSI_STATE_IDLE;
+    }
+}
 
-        // Check if all sectors sent and buffer drained
-        if(ctx->remaining_blocks == 0 && ctx->buffer_offset == 0) {
-            FURI_LOG_D(TAG, "TX: all sectors complete");
-            ctx->state = SCSI_STATE_IDLE;
-            return 0;
-        }
+size_t usb_scsi_rx_peek(UsbScsiContext* ctx, uint8_t** buffer) {
+    if(ctx == NULL || buffer == NULL) {
+        FURI_LOG_E(TAG, "RX: NULL params");
+        return 0;
+    }
 
-        // Need to load next sector?
-        if(ctx->buffer_offset == 0 && ctx->remaining_blocks > 0) {
-            if(!virtual_fat_read_sector(storage, ctx->vfat, ctx->current_lba, ctx->block_buffer)) {
-                FURI_LOG_E(TAG, "Failed to read sector %lu", ctx->current_lba);
-                ctx->state = SCSI_STATE_IDLE;
-                return 0;
-            }
-            ctx->current_lba++;
-            ctx->remaining_blocks--;
-        }
+    *buffer = NULL;
+
+    if(ctx->state != SCSI_STATE_RX_DATA) {
+        FURI_LOG_D(TAG, "RX: not in RX_DATA state (state=%d)", ctx->state);
+        return 0;
+    }
 
-        // Send data from current sector
-        size_t available = SCSI_BLOCK_SIZE - ctx->buffer_offset;
-        bytes_to_send = (available < max_len) ? available : max_len;
+    uint32_t count = ctx->remaining_blocks;
+    if(count > USB_SCSI_STAGING_SECTORS) count = USB_SCSI_STAGING_SECTORS;
 
-        memcpy(buffer, ctx->block_buffer + ctx->buffer_offset, bytes_to_send);
-        ctx->buffer_offset += bytes_to_send;
+    *buffer = ctx->staging_buffer + ctx->buffer_offset;
+    return count * SCSI_BLOCK_SIZE - ctx->buffer_offset;
+}
 
-        if(ctx->buffer_offset >= SCSI_BLOCK_SIZE) {
-            // Sector complete, reset offset for next sector
-            ctx->buffer_offset = 0;
+bool usb_scsi_rx_commit(UsbScsiContext* ctx, size_t len) {
+    if(ctx == NULL || ctx->state != SCSI_STATE_RX_DATA) return false;
 
-            if(ctx->remaining_blocks == 0) {
-                // All sectors sent
-                ctx->state = SCSI_STATE_IDLE;
-            }
-        }
+    // Packets are collected in the staging buffer, each full run is written in one call
+    uint32_t count = ctx->remaining_blocks;
+    if(count > USB_SCSI_STAGING_SECTORS) count = USB_SCSI_STAGING_SECTORS;
+    size_t run_len = count * SCSI_BLOCK_SIZE;
+
+    if(len > run_len - ctx->buffer_offset) {
+        FURI_LOG_E(TAG, "RX: %u bytes overflow the staging run", (unsigned int)len);
+        ctx->state = SCSI_STATE_IDLE;
+        return false;
     }
 
-    return bytes_to_send;
-}
+    ctx->buffer_offset += len;
+    if(ctx->buffer_offset < run_len) return true;
 
-bool usb_scsi_receive_data(UsbScsiContext* ctx, uint8_t* buffer, size_t len) {
-    UNUSED(ctx);
-    UNUSED(buffer);
-    UNUSED(len);
-    // Read-only filesystem, no WRITE support
-    return false;
+    if(!block_device_write_blocks(ctx->device, ctx->current_lba, count, ctx->staging_buffer)) {
+        FURI_LOG_E(TAG, "Failed to write sectors %lu+%lu", ctx->current_lba, count);
+        scsi_set_sense(ctx, SCSI_SENSE_MEDIUM_ERROR, SCSI_ASC_WRITE_FAULT);
+        ctx->state = SCSI_STATE_IDLE;
+        return false;
+    }
+    ctx->current_lba += count;
+    ctx->remaining_blocks -= count;
+    ctx->buffer_offset = 0;
+
+    if(ctx->remaining_blocks == 0) {
+        // All sectors written
+        ctx->state = SCSI_STATE_IDLE;
+    }
+
+    return true;
 }
 
 bool usb_scsi_has_tx_data(UsbScsiContext* ctx) {
     return ctx != NULL && ctx->state == SCSI_STATE_TX_DATA;
 }
 
+uint32_t usb_scsi_tx_length(UsbScsiContext* ctx) {
+    if(ctx == NULL || ctx->state != SCSI_STATE_TX_DATA) return 0;
+
+    if(ctx->is_small_data_mode) return ctx->remaining_blocks - ctx->buffer_offset;
+    return ctx->remaining_blocks * SCSI_BLOCK_SIZE + ctx->next_len +
+           (ctx->staging_len - ctx->buffer_offset);
+}
+
+uint32_t usb_scsi_rx_length(UsbScsiContext* ctx) {
+    if(ctx == NULL || ctx->state != SCSI_STATE_RX_DATA) return 0;
+    return ctx->remaining_blocks * SCSI_BLOCK_SIZE - ctx->buffer_offset;
+}
+
 void usb_scsi_get_sense_data(UsbScsiContext* ctx, uint8_t* buffer) {
     if(ctx == NULL || buffer == NULL) return;
 
@@ -515,8 +798,3 @@ void usb_scsi_get_sense_data(UsbScsiContext* ctx, uint8_t* buffer) {
     ctx->asc = 0;
 }
 
-void usb_scsi_set_storage(UsbScsiContext* ctx, Storage* storage) {
-    if(ctx) {
-        ctx->storage = storage;
-    }
-}
@@ -1,39 +1,54 @@
 #pragma once
 
 #include <furi.h>
-#include "../disk/virtual_fat.h"
+#include "../disk/block_device.h"
 #include "usb_scsi_commands.h"
 
 /**
  * USB SCSI command handler
  * Implements SCSI Block Commands for USB Mass Storage
- * Uses virtual FAT filesystem for on-the-fly sector generation
+ * Serves any BlockDevice backend (virtual FAT, raw image, caches on top of them)
  */
 
+/**
+ * READ_10 staging buffer size in sectors
+ * A whole run of sectors is fetched in one backend call, so larger
+ * values mean fewer SD round trips at the cost of heap (4-16KB is sane).
+ * Two buffers are allocated: one drains to the endpoint while a stager
+ * thread reads the next run into the other.
+ */
+#ifndef USB_SCSI_STAGING_SECTORS
+#define USB_SCSI_STAGING_SECTORS 8
+#endif
+
 typedef struct UsbScsiContext UsbScsiContext;
 
 /**
  * Allocate SCSI context
+ * Starts the READ_10 stager thread, usb_scsi_free stops it
  * @return Context pointer or NULL on error
  */
 UsbScsiContext* usb_scsi_alloc(void);
 
 /**
  * Free SCSI context
+ * Waits for a READ_10 run still being read, so free it before the block device
  * @param ctx Context to free
  */
 void usb_scsi_free(UsbScsiContext* ctx);
 
 /**
- * Set virtual FAT filesystem for SCSI operations
+ * Set block device for SCSI operations
+ * Block size must be SCSI_BLOCK_SIZE. WRITE_10 is only accepted when the
+ * device is writable, the medium is reported write protected otherwise.
  * @param ctx Context
- * @param vfat Virtual FAT instance (ownership NOT transferred)
+ * @param device Block device (ownership NOT transferred)
  * @return true on success, false on error
  */
-bool usb_scsi_set_virtual_fat(UsbScsiContext* ctx, VirtualFat* vfat);
+bool usb_scsi_set_block_device(UsbScsiContext* ctx, BlockDevice* device);
 
 /**
- * Clear virtual FAT
+ * Clear block device
  * @param ctx Context
  */
 void usb_scsi_clear(UsbScsiContext* ctx);
@@ -48,22 +63,69 @@ void usb_scsi_clear(UsbScsiContext* ctx);
 bool usb_scsi_process_command(UsbScsiContext* ctx, uint8_t* cmd, uint8_t cmd_len);
 
 /**
- * Transmit data to host
+ * Answer a polled command from the precomputed response table
+ * TEST_UNIT_READY, INQUIRY, READ_CAPACITY_10, MODE_SENSE and REQUEST_SENSE
+ * have fixed responses (rebuilt when the block device changes), so they are
+ * answered here without any device access. The command has the same effect
+ * as through usb_scsi_process_command, including the staged data IN: send
+ * the returned response in one go and mark it with usb_scsi_tx_consume, or
+ * leave it to usb_scsi_tx_peek. Nothing changes if it is not answered.
+ * @param ctx Context
+ * @param cmd Command buffer
+ * @param cmd_len Command length
+ * @param host_length Transfer length the host expects (CBW dDataLength)
+ * @param data Output pointer to the response, valid until the next command
+ * @param len Output response length (0 for TEST_UNIT_READY)
+ * @return true if answered, false if the command must go through
+ *         usb_scsi_process_command (other commands, ones that fail, or a
+ *         response length other than host_length)
+ */
+bool usb_scsi_fast_command(
+    UsbScsiContext* ctx,
+    const uint8_t* cmd,
+    uint8_t cmd_len,
+    uint32_t host_length,
+    const uint8_t** data,
+    size_t* len);
+
+/**
+ * Get the next bytes to transmit to host
+ * Points straight into the staging buffer, so the endpoint can send from it
+ * without an intermediate copy. Swaps in the next run of READ_10 sectors once
+ * the current one is consumed, waiting for the stager if it is still reading
+ * it. The bytes stay valid until usb_scsi_tx_consume.
  * @param ctx Context
- * @param buffer Output buffer
- * @param max_len Maximum bytes to write
- * @return Number of bytes written, or 0 if no data
+ * @param data Output pointer to the contiguous ready bytes
+ * @return Number of ready bytes, or 0 if no data (or the device read failed)
  */
-size_t usb_scsi_transmit_data(UsbScsiContext* ctx, uint8_t* buffer, size_t max_len);
+size_t usb_scsi_tx_peek(UsbScsiContext* ctx, const uint8_t** data);
 
 /**
- * Receive data from host
+ * Mark bytes returned by usb_scsi_tx_peek as sent
  * @param ctx Context
- * @param buffer Input buffer
- * @param len Data length
- * @return true on success
+ * @param len Bytes sent (at most the length returned by usb_scsi_tx_peek)
  */
-bool usb_scsi_receive_data(UsbScsiContext* ctx, uint8_t* buffer, size_t len);
+void usb_scsi_tx_consume(UsbScsiContext* ctx, size_t len);
+
+/**
+ * Get space for the next bytes from host (WRITE_10 data phase)
+ * Points straight into the staging buffer, so the endpoint can read into it
+ * without an intermediate copy. Commit the bytes with usb_scsi_rx_commit.
+ * @param ctx Context
+ * @param buffer Output pointer to the free space (NULL if no write is pending)
+ * @return Free bytes up to the end of the current staging run, 0 if no write is pending
+ */
+size_t usb_scsi_rx_peek(UsbScsiContext* ctx, uint8_t** buffer);
+
+/**
+ * Commit bytes received into the space returned by usb_scsi_rx_peek
+ * Sectors are written to the device once a staging run is complete
+ * @param ctx Context
+ * @param len Bytes received
+ * @return true on success, false if no write is pending, len overflows the
+ *         space or the device failed
+ */
+bool usb_scsi_rx_commit(UsbScsiContext* ctx, size_t len);
 
 /**
  * Check if command has data to transmit
@@ -73,15 +135,24 @@ bool usb_scsi_receive_data(UsbScsiContext* ctx, uint8_t* buffer, size_t len);
 bool usb_scsi_has_tx_data(UsbScsiContext* ctx);
 
 /**
- * Get sense data for REQUEST_SENSE command
+ * Get the data IN bytes the current command still intends to send
+ * Right after usb_scsi_process_command this is the whole data IN phase.
+ * Short responses are already cut to the CDB allocation length.
  * @param ctx Context
- * @param buffer Output buffer (must be 18 bytes)
+ * @return Bytes left to send, 0 if the command has no data IN phase
  */
-void usb_scsi_get_sense_data(UsbScsiContext* ctx, uint8_t* buffer);
+uint32_t usb_scsi_tx_length(UsbScsiContext* ctx);
 
 /**
- * Set storage for SCSI context
+ * Get the data OUT bytes the current command still expects
  * @param ctx Context
- * @param storage Storage instance
+ * @return Bytes left to receive, 0 if the command has no data OUT phase
  */
-void usb_scsi_set_storage(UsbScsiContext* ctx, Storage* storage);
+uint32_t usb_scsi_rx_length(UsbScsiContext* ctx);
+
+/**
+ * Get sense data for REQUEST_SENSE command
+ * @param ctx Context
+ * @param buffer Output buffer (must be 18 bytes)
+ */
+void usb_scsi_get_sense_data(UsbScsiContext* ctx, uint8_t* buffer);
@@ -36,9 +36,12 @@
 /**
  * SCSI Additional Sense Codes
  */
+#define SCSI_ASC_WRITE_FAULT          0x03
+#define SCSI_ASC_UNRECOVERED_READ     0x11
 #define SCSI_ASC_INVALID_COMMAND      0x20
 #define SCSI_ASC_LBA_OUT_OF_RANGE     0x21
 #define SCSI_ASC_INVALID_FIELD_IN_CDB 0x24
+#define SCSI_ASC_WRITE_PROTECTED      0x27
 #define SCSI_ASC_MEDIUM_NOT_PRESENT   0x3A
 
 /**
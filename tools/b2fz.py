@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Pack a payload into the boot2flipper block-compressed format (B2FZ).
+
+The file is split into independent LZ4 blocks with an offset index, so the
+Flipper only reads and decodes the blocks the host asks for. Packed files are
+detected by their header: keep the original name on the SD card, e.g.
+
+    python3 tools/b2fz.py ipxe.efi packed/ipxe.efi
+
+No dependencies beyond the Python standard library.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"B2FZ"
+HEADER_SIZE = 16
+MAX_BLOCK_SIZE = 16 * 1024
+MAX_BLOCKS = 1024
+
+# LZ4 block format limits
+MIN_MATCH = 4
+LAST_LITERALS = 5  # The last 5 bytes are always literals
+MF_LIMIT = 12  # The last match must start at least 12 bytes before the end
+MAX_OFFSET = 65535
+
+
+def _write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def _write_sequence(out, literals, offset=0, match_length=0):
+    literal_count = len(literals)
+    token = min(literal_count, 15) << 4
+    if offset:
+        token |= min(match_length - MIN_MATCH, 15)
+    out.append(token)
+    if literal_count >= 15:
+        _write_length(out, literal_count - 15)
+    out += literals
+    if offset:
+        out += struct.pack("<H", offset)
+        if match_length - MIN_MATCH >= 15:
+            _write_length(out, match_length - MIN_MATCH - 15)
+
+
+def lz4_compress_block(data):
+    """Greedy LZ4 block compressor, one hash table entry per 4-byte key."""
+    size = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    pos = 0
+
+    while pos < size - MF_LIMIT:
+        key = data[pos : pos + MIN_MATCH]
+        candidate = table.get(key)
+        table[key] = pos
+
+        if candidate is None or pos - candidate > MAX_OFFSET:
+            pos += 1
+            continue
+
+        length = MIN_MATCH
+        limit = size - LAST_LITERALS - pos
+        while length < limit and data[candidate + length] == data[pos + length]:
+            length += 1
+
+        _write_sequence(out, data[anchor:pos], pos - candidate, length)
+        pos += length
+        anchor = pos
+
+    _write_sequence(out, data[anchor:])
+    return bytes(out)
+
+
+def pack(data, block_size):
+    block_count = (len(data) + block_size - 1) // block_size
+    if block_count > MAX_BLOCKS:
+        raise ValueError(
+            f"{block_count} blocks exceed the {MAX_BLOCKS} block limit, use larger blocks"
+        )
+
+    blocks = []
+    for start in range(0, len(data), block_size):
+        raw = data[start : start + block_size]
+        packed = lz4_compress_block(raw)
+        # Blocks that do not shrink are stored as is
+        blocks.append(packed if len(packed) < len(raw) else raw)
+
+    offset = HEADER_SIZE + (block_count + 1) * 4
+    offsets = []
+    for block in blocks:
+        offsets.append(offset)
+        offset += len(block)
+    offsets.append(offset)
+
+    header = MAGIC + struct.pack("<III", block_size, len(data), block_count)
+    index = struct.pack(f"<{block_count + 1}I", *offsets)
+    return header + index + b"".join(blocks)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="payload to pack (e.g. ipxe.efi)")
+    parser.add_argument("output", help="packed file to write")
+    parser.add_argument(
+        "-b",
+        "--block-size",
+        type=int,
+        default=8192,
+        help="uncompressed block size, power of two from 512 to 16384 (default: 8192)",
+    )
+    args = parser.parse_args()
+
+    block_size = args.block_size
+    if block_size < 512 or block_size > MAX_BLOCK_SIZE or block_size & (block_size - 1):
+        parser.error("block size must be a power of two from 512 to 16384")
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    if data[:4] == MAGIC:
+        parser.error(f"{args.input} is already packed")
+
+    try:
+        packed = pack(data, block_size)
+    except ValueError as e:
+        parser.error(str(e))
+
+    with open(args.output, "wb") as f:
+        f.write(packed)
+
+    ratio = len(packed) / len(data) * 100 if data else 100
+    print(f"{args.input}: {len(data)} -> {len(packed)} bytes ({ratio:.1f}%)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())